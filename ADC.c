@@ -1,13 +1,43 @@
 #include "ADC.h"
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
+
+#if ADC_CLOCK < 50000 || ADC_CLOCK > 200000
+#error "the ADC clock is out of 50-200 kHz, change ADC_PRESCALER"
+#endif
+
+// the ADPS bits of ADC_PRESCALER
+#if ADC_PRESCALER == 64
+#define ADC_PRESCALER_BITS (1 << ADPS2 | 1 << ADPS1)
+#elif ADC_PRESCALER == 128
+#define ADC_PRESCALER_BITS (1 << ADPS2 | 1 << ADPS1 | 1 << ADPS0)
+#else
+#error "no ADPS bits for ADC_PRESCALER"
+#endif
+
+// the channels of running sweep and the buffer for their values
+static const uint8_t *ADC_sweep_channels;
+static uint16_t *ADC_sweep_samples;
+static uint8_t ADC_sweep_amount = 0;
+// the amount of conversions summed per channel
+static uint8_t ADC_sweep_oversample = 1;
+
+// the index of channel being converted
+static volatile uint8_t ADC_sweep_index = 0;
+// the amount of conversions of this channel, including the discarded one
+static volatile uint8_t ADC_sweep_conversions = 0;
+// the sum of conversions of this channel
+static volatile uint16_t ADC_sweep_sum = 0;
+// 1 if the sweep is over
+static volatile uint8_t ADC_sweep_done = 1;
 
 /*
  * Enable ADC subsystem
  */
 void f_enable_ADC() {
-    // write 1 to ADEN bit of ADC configuration register
-    ADCSRA = 1 << ADEN;
+    // write 1 to ADEN bit of ADC configuration register, the clock is ADC_CLOCK
+    ADCSRA = 1 << ADEN | ADC_PRESCALER_BITS;
 
     // disable the PORTA
     DDRA = 0x00;
@@ -42,4 +72,72 @@ uint16_t f_read_ADC(uint8_t channel) {
 void f_disable_ADC() {
     // turn off ADC part of chip, by writing 0x00 to ADC configuration register
     ADCSRA = 0x00;
+}
+
+
+/*
+ * Start converting the channels one by one in background.
+ * Every channel is converted oversample + 1 times (oversample is up to 64),
+ * the first value is discarded and the others are summed.
+ * The sums are put to samples, f_is_ADC_sweep_done() tells when.
+ * ADC must be enabled, interrupts must be enabled.
+ */
+void f_start_ADC_sweep(const uint8_t *channels, uint8_t amount, uint8_t oversample, uint16_t *samples) {
+    if (amount == 0) return;
+
+    ADC_sweep_channels = channels;
+    ADC_sweep_samples = samples;
+    ADC_sweep_amount = amount;
+    ADC_sweep_oversample = oversample;
+
+    ADC_sweep_index = 0;
+    ADC_sweep_conversions = 0;
+    ADC_sweep_sum = 0;
+    ADC_sweep_done = 0;
+
+    // set the first channel
+    ADMUX = 1 << REFS0 | channels[0];
+
+    // start the conversion, the interrupt does the rest
+    ADCSRA |= 1 << ADIE | 1 << ADSC;
+}
+
+
+/*
+ * Returns 1 if the sweep is over.
+ */
+uint8_t f_is_ADC_sweep_done(void) {
+    return ADC_sweep_done;
+}
+
+
+/*
+ * The conversion is complete.
+ */
+ISR(ADC_vect) {
+    uint16_t value = (0x0000 | ADCL) | (ADCH << 8);
+
+    // the first conversion of channel only settles the input
+    if (ADC_sweep_conversions++) ADC_sweep_sum += value;
+
+    // the channel is converted again
+    if (ADC_sweep_conversions <= ADC_sweep_oversample) {
+        ADCSRA |= 1 << ADSC;
+        return;
+    }
+
+    ADC_sweep_samples[ADC_sweep_index++] = ADC_sweep_sum;
+
+    // all channels are converted
+    if (ADC_sweep_index == ADC_sweep_amount) {
+        ADCSRA &= ~(1 << ADIE);
+        ADC_sweep_done = 1;
+        return;
+    }
+
+    // next channel
+    ADC_sweep_conversions = 0;
+    ADC_sweep_sum = 0;
+    ADMUX = 1 << REFS0 | ADC_sweep_channels[ADC_sweep_index];
+    ADCSRA |= 1 << ADSC;
 }
\ No newline at end of file
@@ -3,6 +3,16 @@
 
 #include <stdint.h>
 
+// the prescaler of ADC clock, the datasheet wants 50-200 kHz for 10-bit results
+// (125 kHz at 8 MHz)
+#define ADC_PRESCALER 64UL
+#define ADC_CLOCK (F_CPU / ADC_PRESCALER)
+
+// the ADC clock periods of one conversion, the first one after enabling takes longer
+// a sweep of n conversions takes ADC_FIRST_CONVERSION_CYCLES + (n - 1) * ADC_CONVERSION_CYCLES
+#define ADC_CONVERSION_CYCLES 13
+#define ADC_FIRST_CONVERSION_CYCLES 25
+
 /*
  * Enable ADC subsystem
  */
@@ -19,4 +29,18 @@ uint16_t f_read_ADC(uint8_t channel);
  */
 void f_disable_ADC();
 
+/*
+ * Start converting the channels one by one in background.
+ * Every channel is converted oversample + 1 times (oversample is up to 64),
+ * the first value is discarded and the others are summed.
+ * The sums are put to samples, f_is_ADC_sweep_done() tells when.
+ * ADC must be enabled, interrupts must be enabled.
+ */
+void f_start_ADC_sweep(const uint8_t *channels, uint8_t amount, uint8_t oversample, uint16_t *samples);
+
+/*
+ * Returns 1 if the sweep is over.
+ */
+uint8_t f_is_ADC_sweep_done(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef MOHG__HAL_AVR_H
+#define MOHG__HAL_AVR_H
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/delay.h>
+
+#include "../macros.h"
+
+// the macros take the letter of port, the extra level lets the aliases expand
+#define __HAL_gpio_write(PORT_LETTER, PIN_NUMBER, STATE) \
+	do SET_PIN_STATE(PORT##PORT_LETTER, PIN_NUMBER, STATE) while (0)
+#define __HAL_gpio_write_mask(PORT_LETTER, MASK, VALUE) \
+	do PORT##PORT_LETTER = (PORT##PORT_LETTER & ~(MASK)) | ((VALUE) & (MASK)); while (0)
+#define __HAL_gpio_read(PORT_LETTER, PIN_NUMBER) \
+	GET_PIN_STATE(PIN##PORT_LETTER, PIN_NUMBER)
+#define __HAL_gpio_direction(PORT_LETTER, PIN_NUMBER, DIRECTION) \
+	do SET_PIN_DIRECTION(DDR##PORT_LETTER, PIN_NUMBER, DIRECTION) while (0)
+
+// set pin to 1 or 0
+#define HAL_gpio_write(PORT_LETTER, PIN_NUMBER, STATE) \
+	__HAL_gpio_write(PORT_LETTER, PIN_NUMBER, STATE)
+
+// set the pins of mask to the bits of value at once
+#define HAL_gpio_write_mask(PORT_LETTER, MASK, VALUE) \
+	__HAL_gpio_write_mask(PORT_LETTER, MASK, VALUE)
+
+// get pin state (non-zero if high)
+#define HAL_gpio_read(PORT_LETTER, PIN_NUMBER) \
+	__HAL_gpio_read(PORT_LETTER, PIN_NUMBER)
+
+// 1 - out, 0 - in
+#define HAL_gpio_direction(PORT_LETTER, PIN_NUMBER, DIRECTION) \
+	__HAL_gpio_direction(PORT_LETTER, PIN_NUMBER, DIRECTION)
+
+// enable/disable interrupts globally
+#define HAL_enable_interrupts() sei()
+#define HAL_disable_interrupts() cli()
+
+// busy wait, the time must be a constant
+#define HAL_delay_ms(ms) _delay_ms(ms)
+
+#endif
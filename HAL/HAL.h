@@ -0,0 +1,24 @@
+#ifndef MOHG__HAL_H
+#define MOHG__HAL_H
+
+/*
+    Hardware abstraction layer.
+
+    GPIO, interrupts and delays are declared by the backend header below.
+    ADC, timers, I2C and sleeping are declared by their own headers
+    (ADC.h, timers.h, I2C/I2C.h, idle.h):
+     - the AVR backend is ADC.c, timers.c, I2C/I2C.c and idle.c (compile.sh);
+     - the host backend is in HAL/host (compile_host.sh), it simulates
+       the glove, so the firmware runs as a Linux program.
+
+    The GPIO ports are specified by their letters:
+        HAL_gpio_write(B, PB1, 1);
+*/
+
+#ifdef MOHG_HOST
+#include "host/host.h"
+#else
+#include "AVR.h"
+#endif
+
+#endif
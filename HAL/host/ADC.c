@@ -0,0 +1,53 @@
+#include "../../ADC.h"
+
+#include "../../timers.h"
+#include "host.h"
+
+// the time the sweep is over at (in timer clock periods)
+static uint32_t g_host_sweep_end = 0;
+
+
+/*
+ * Enable ADC subsystem
+ */
+void f_enable_ADC() {
+}
+
+/*
+ * Read the value from ADC pin.
+ * Returns an integer from 0 to 1023.
+ */
+uint16_t f_read_ADC(uint8_t channel) {
+    return f_sim_read_ADC(channel);
+}
+
+/*
+ * Disable ADC subsystem
+ */
+void f_disable_ADC() {
+}
+
+/*
+ * Convert the channels and sum the conversions at once,
+ * the sweep is over after the time it takes on the device.
+ */
+void f_start_ADC_sweep(const uint8_t *channels, uint8_t amount, uint8_t oversample, uint16_t *samples) {
+    for (uint8_t i = 0; i < amount; i++) {
+        samples[i] = 0;
+
+        for (uint8_t n = 0; n < oversample; n++)
+            samples[i] += f_sim_read_ADC(channels[i]);
+    }
+
+    // the first conversion of every channel is discarded, see ADC.c
+    uint32_t cycles = ADC_FIRST_CONVERSION_CYCLES + ((uint32_t)amount * (oversample + 1) - 1) * ADC_CONVERSION_CYCLES;
+
+    g_host_sweep_end = f_timer_get_counts() + (cycles * ADC_PRESCALER + TIMER_PRESCALER - 1) / TIMER_PRESCALER;
+}
+
+/*
+ * Returns 1 if the sweep is over.
+ */
+uint8_t f_is_ADC_sweep_done(void) {
+    return (int32_t)(f_timer_get_counts() - g_host_sweep_end) >= 0;
+}
@@ -0,0 +1,51 @@
+#include "../../I2C/I2C.h"
+
+#include "host.h"
+
+// the virtual display is the only device on the bus, nothing fails
+volatile uint16_t I2C_error_count = 0;
+
+
+void I2C_setup(void) {
+}
+
+void I2C_start(void) {
+	f_display_start();
+}
+
+void I2C_wait_for_end(void) {
+}
+
+void I2C_send_one(uint8_t byte) {
+	f_display_byte(byte);
+}
+
+void I2C_send(const uint8_t* bytes, uint16_t length) {
+	for (uint16_t i = 0; i < length; i++)
+		f_display_byte(bytes[i]);
+}
+
+void I2C_stop(void) {
+	f_display_stop();
+}
+
+void I2C_disable(void) {
+}
+
+// the transaction is sent at once
+void I2C_submit(const I2C_transaction *transaction) {
+	I2C_start();
+	I2C_send_one(I2C_get_addr_byte(transaction->address, 1));
+	I2C_send(transaction->header, transaction->header_length);
+	I2C_send(transaction->bytes, transaction->length);
+	I2C_stop();
+
+	if (transaction->on_complete) transaction->on_complete();
+}
+
+uint8_t I2C_is_busy(void) {
+	return 0;
+}
+
+void I2C_wait_idle(void) {
+}
@@ -0,0 +1,348 @@
+#include "host.h"
+
+#include <stdio.h>
+
+#include "../../I2C/I2C.h"
+#include "../../SSD1306/SSD1306.h"
+
+/*
+    The emulator of SSD1306 on the I2C bus.
+
+    It decodes the control bytes, the commands of SSD1306 datasheet and the
+    three addressing modes into GDDRAM, so it is the reference for rendering.
+    The image is what the panel shows: the display on/off, inversion, entire
+    display on, start line, multiplex ratio, offset, segment remap and COM
+    scan direction are applied. The module is mounted so the configuration of
+    SSD1306_setup() (remapped segments, reversed COM scan) is upright.
+    The alternative COM pins configuration and scrolling are not emulated.
+*/
+
+// the size of GDDRAM
+#define DISPLAY_COLUMNS 128
+#define DISPLAY_PAGES 8
+#define DISPLAY_ROWS (DISPLAY_PAGES * 8)
+
+// the addressing modes
+#define DISPLAY_HORIZONTAL 0
+#define DISPLAY_VERTICAL 1
+#define DISPLAY_PAGE 2
+
+// the memory of display
+static uint8_t g_display_ram[DISPLAY_PAGES][DISPLAY_COLUMNS];
+
+// the addressing
+static uint8_t g_display_mode = DISPLAY_PAGE;
+static uint8_t g_display_column_start = 0;
+static uint8_t g_display_column_end = DISPLAY_COLUMNS - 1;
+static uint8_t g_display_page_start = 0;
+static uint8_t g_display_page_end = DISPLAY_PAGES - 1;
+static uint8_t g_display_column = 0;
+static uint8_t g_display_page = 0;
+
+// the configuration of panel (the values after reset)
+static uint8_t g_display_is_on = 0;
+static uint8_t g_display_is_inverse = 0;
+static uint8_t g_display_is_all_on = 0;
+static uint8_t g_display_start_line = 0;
+static uint8_t g_display_multiplex = DISPLAY_ROWS - 1;
+static uint8_t g_display_offset = 0;
+static uint8_t g_display_is_remapped = 0;
+static uint8_t g_display_is_scan_reversed = 0;
+
+// the state of transaction
+static uint16_t g_display_position = 0;
+static uint8_t g_display_is_selected = 0;
+// 1 if the next byte is a control byte
+static uint8_t g_display_expects_control = 0;
+// 1 if the control byte has Co bit, only one byte follows it
+static uint8_t g_display_is_single = 0;
+// 1 if the bytes after control byte are data
+static uint8_t g_display_is_data = 0;
+// the command being received and its parameters
+static uint8_t g_display_command[8];
+static uint8_t g_display_command_length = 0;
+
+// 1 if the image may have changed since the last check
+static uint8_t g_display_is_changed = 0;
+
+// the statistics
+static display_stats g_display_stats;
+
+
+// returns the amount of parameters of command
+static uint8_t f_display_parameters(uint8_t command) {
+    switch (command) {
+        case 0x26: // horizontal scroll
+        case 0x27:
+            return 6;
+        case 0x29: // vertical and horizontal scroll
+        case 0x2A:
+            return 5;
+        case __SSD1306_CMD__Column_Address_Set:
+        case __SSD1306_CMD__Page_Address_Set:
+        case 0xA3: // vertical scroll area
+            return 2;
+        case __SSD1306_CMD__Memory_Addressing_Set:
+        case __SSD1306_CMD__Contrast_Set:
+        case __SSD1306_CMD__Multiplex_Radio_Set:
+        case __SSD1306_CMD__Display_Offset_Set:
+        case __SSD1306_CMD__Display_Clock_Div_Ratio_Set:
+        case __SSD1306_CMD__Com_Pins_Set:
+        case __SSD1306_CMD__Precharge_Period_Set:
+        case __SSD1306_CMD__VCOMH_Deselect_Level_Set:
+        case __SSD1306_CMD__Charge_Pump_Set:
+            return 1;
+    }
+
+    return 0;
+}
+
+// executes the command with parameters
+static void f_display_execute(void) {
+    uint8_t *c = g_display_command;
+
+    // the image depends on almost every command
+    g_display_is_changed = 1;
+
+    // the commands with the value in low bits
+    if (c[0] <= 0x0F) {
+        g_display_column = (g_display_column & 0xF0) | c[0];
+        return;
+    }
+    if (c[0] <= 0x1F) {
+        g_display_column = (g_display_column & 0x0F) | (c[0] & 0x07) << 4;
+        return;
+    }
+    if (c[0] >= 0x40 && c[0] <= 0x7F) {
+        g_display_start_line = c[0] & 0x3F;
+        return;
+    }
+    if (c[0] >= 0xB0 && c[0] <= 0xB7) {
+        g_display_page = c[0] & 0x07;
+        return;
+    }
+
+    switch (c[0]) {
+        case __SSD1306_CMD__Memory_Addressing_Set:
+            g_display_mode = c[1] & 0x03;
+            // 3 is invalid
+            if (g_display_mode > DISPLAY_PAGE) g_display_stats.errors++;
+        break;
+        case __SSD1306_CMD__Column_Address_Set:
+            g_display_column_start = g_display_column = c[1] & 0x7F;
+            g_display_column_end = c[2] & 0x7F;
+        break;
+        case __SSD1306_CMD__Page_Address_Set:
+            g_display_page_start = g_display_page = c[1] & 0x07;
+            g_display_page_end = c[2] & 0x07;
+        break;
+        case __SSD1306_CMD__Display_On: g_display_is_on = 1; break;
+        case __SSD1306_CMD__Display_Off: g_display_is_on = 0; break;
+        case 0xA4: g_display_is_all_on = 0; break;
+        case 0xA5: g_display_is_all_on = 1; break;
+        case 0xA6: g_display_is_inverse = 0; break;
+        case 0xA7: g_display_is_inverse = 1; break;
+        case 0xA0: g_display_is_remapped = 0; break;
+        case 0xA1: g_display_is_remapped = 1; break;
+        case __SSD1306_CMD__Com_Output_Scan_Inc: g_display_is_scan_reversed = 0; break;
+        case __SSD1306_CMD__Com_Output_Scan_Dec: g_display_is_scan_reversed = 1; break;
+        case __SSD1306_CMD__Multiplex_Radio_Set:
+            g_display_multiplex = c[1] & 0x3F;
+            // less than 16 rows is invalid
+            if (g_display_multiplex < 15) g_display_stats.errors++;
+        break;
+        case __SSD1306_CMD__Display_Offset_Set: g_display_offset = c[1] & 0x3F; break;
+        case __SSD1306_CMD__Contrast_Set:
+        case __SSD1306_CMD__Display_Clock_Div_Ratio_Set:
+        case __SSD1306_CMD__Com_Pins_Set:
+        case __SSD1306_CMD__Precharge_Period_Set:
+        case __SSD1306_CMD__VCOMH_Deselect_Level_Set:
+        case __SSD1306_CMD__Charge_Pump_Set:
+        case __SSD1306_CMD__Nop:
+        case 0x26: case 0x27: case 0x29: case 0x2A: case 0xA3: case 0x2E: case 0x2F:
+            // the analog settings and scrolling don't change the image here
+        break;
+        default:
+            g_display_stats.errors++;
+    }
+}
+
+// receives the command byte
+static void f_display_command_byte(uint8_t byte) {
+    g_display_stats.command_bytes++;
+
+    g_display_command[g_display_command_length++] = byte;
+
+    if (g_display_command_length > f_display_parameters(g_display_command[0])) {
+        f_display_execute();
+        g_display_command_length = 0;
+    }
+}
+
+// receives the data byte, writes it to GDDRAM and moves the cursor
+static void f_display_data_byte(uint8_t byte) {
+    g_display_stats.data_bytes++;
+
+    g_display_ram[g_display_page][g_display_column] = byte;
+    g_display_is_changed = 1;
+
+    switch (g_display_mode) {
+        case DISPLAY_HORIZONTAL:
+            if (g_display_column++ != g_display_column_end) return;
+            g_display_column = g_display_column_start;
+
+            if (g_display_page++ != g_display_page_end) return;
+            g_display_page = g_display_page_start;
+        break;
+        case DISPLAY_VERTICAL:
+            if (g_display_page++ != g_display_page_end) return;
+            g_display_page = g_display_page_start;
+
+            if (g_display_column++ != g_display_column_end) return;
+            g_display_column = g_display_column_start;
+        break;
+        default:
+            // page addressing: the column wraps, the page stays
+            g_display_column = (g_display_column + 1) % DISPLAY_COLUMNS;
+    }
+}
+
+
+void f_display_start(void) {
+    g_display_stats.starts++;
+
+    g_display_position = 0;
+    g_display_is_selected = 0;
+
+    // the unfinished command is dropped
+    if (g_display_command_length) g_display_stats.errors++;
+    g_display_command_length = 0;
+}
+
+void f_display_byte(uint8_t byte) {
+    g_display_stats.bytes++;
+
+    // the address byte
+    if (g_display_position++ == 0) {
+        g_display_is_selected = byte == I2C_get_addr_byte(__SSD1306_ADDRESS, 1);
+        g_display_expects_control = 1;
+
+        if (!g_display_is_selected) g_display_stats.foreign_bytes++;
+        return;
+    }
+
+    if (!g_display_is_selected) {
+        g_display_stats.foreign_bytes++;
+        return;
+    }
+
+    // the control byte: Co and D/C bits
+    if (g_display_expects_control) {
+        g_display_is_single = byte & 0x80;
+        g_display_is_data = byte & 0x40;
+        g_display_expects_control = 0;
+
+        // the rest of bits must be zero
+        if (byte & 0x3F) g_display_stats.errors++;
+        return;
+    }
+
+    if (g_display_is_data) f_display_data_byte(byte);
+    else f_display_command_byte(byte);
+
+    // with Co bit the control byte is before every byte
+    if (g_display_is_single) g_display_expects_control = 1;
+}
+
+void f_display_stop(void) {
+    g_display_stats.stops++;
+
+    g_display_is_selected = 0;
+}
+
+
+uint8_t f_display_pixel(uint8_t x, uint8_t y) {
+    if (!g_display_is_on) return 0;
+    if (g_display_is_all_on) return 1;
+
+    // the rows beyond multiplex ratio are dark
+    if (y > g_display_multiplex) return 0;
+
+    // the upright mounting is remapped and reversed, see above
+    uint8_t column = g_display_is_remapped ? x : DISPLAY_COLUMNS - 1 - x;
+    uint8_t com = g_display_is_scan_reversed ? y : g_display_multiplex - y;
+
+    uint8_t row = (com + g_display_offset + g_display_start_line) % DISPLAY_ROWS;
+    uint8_t pixel = g_display_ram[row / 8][column] >> row % 8 & 1;
+
+    return pixel ^ g_display_is_inverse;
+}
+
+uint8_t f_display_is_changed(void) {
+    uint8_t is_changed = g_display_is_changed;
+    g_display_is_changed = 0;
+
+    return is_changed;
+}
+
+const display_stats *f_display_get_stats(void) {
+    return &g_display_stats;
+}
+
+uint32_t f_display_bus_time_us(void) {
+    // 9 clocks per byte (with ACK), about one clock for every START and STOP
+    uint64_t clocks =
+        9ULL * g_display_stats.bytes +
+        g_display_stats.starts +
+        g_display_stats.stops;
+
+    return clocks * 1000000 / I2C_FREQ;
+}
+
+void f_display_print(void) {
+    for (uint8_t y = 0; y < __SSD1306_HEIGHT; y++) {
+        putchar('|');
+
+        for (uint8_t x = 0; x < __SSD1306_WIDTH; x++)
+            putchar(f_display_pixel(x, y) ? '#' : ' ');
+
+        putchar('|');
+        putchar('\n');
+    }
+}
+
+uint8_t f_display_write_pbm(const char *path) {
+    FILE *file = fopen(path, "wb");
+    if (!file) return 0;
+
+    // binary PBM, the lit pixels are black
+    fprintf(file, "P4\n%d %d\n", __SSD1306_WIDTH, __SSD1306_HEIGHT);
+
+    for (uint8_t y = 0; y < __SSD1306_HEIGHT; y++) {
+        for (uint8_t x = 0; x < __SSD1306_WIDTH; x += 8) {
+            uint8_t byte = 0;
+
+            for (uint8_t bit = 0; bit < 8; bit++)
+                if (x + bit < __SSD1306_WIDTH && f_display_pixel(x + bit, y))
+                    byte |= 0x80 >> bit;
+
+            fputc(byte, file);
+        }
+    }
+
+    fclose(file);
+    return 1;
+}
+
+void f_display_print_stats(void) {
+    printf("i2c: %u starts, %u stops, %u bytes (%u data, %u commands, %u to other devices), %u us of bus time at %lu Hz\n",
+        g_display_stats.starts,
+        g_display_stats.stops,
+        g_display_stats.bytes,
+        g_display_stats.data_bytes,
+        g_display_stats.command_bytes,
+        g_display_stats.foreign_bytes,
+        f_display_bus_time_us(),
+        I2C_FREQ);
+    printf("ssd1306: %u protocol errors\n", g_display_stats.errors);
+}
@@ -0,0 +1,36 @@
+#include "host.h"
+
+// the I/O registers of ports
+static uint8_t g_host_ddr[HOST_PORT_AMOUNT];
+static uint8_t g_host_port[HOST_PORT_AMOUNT];
+
+
+void f_host_gpio_write(uint8_t port, uint8_t pin, uint8_t state) {
+    if (state) g_host_port[port] |= 1 << pin;
+    else g_host_port[port] &= ~(1 << pin);
+}
+
+void f_host_gpio_write_mask(uint8_t port, uint8_t mask, uint8_t value) {
+    g_host_port[port] = (g_host_port[port] & ~mask) | (value & mask);
+}
+
+uint8_t f_host_gpio_read(uint8_t port, uint8_t pin) {
+    // the output pins read their own level
+    if (g_host_ddr[port] & 1 << pin)
+        return g_host_port[port] & 1 << pin;
+
+    // the pressed button pulls the input down
+    if (f_sim_is_pressed(port, pin)) return 0;
+
+    // the pull-up resistor is enabled by PORT bit, the floating input reads 0
+    return g_host_port[port] & 1 << pin;
+}
+
+void f_host_gpio_direction(uint8_t port, uint8_t pin, uint8_t direction) {
+    if (direction) g_host_ddr[port] |= 1 << pin;
+    else g_host_ddr[port] &= ~(1 << pin);
+}
+
+uint8_t f_host_gpio_output(uint8_t port, uint8_t pin) {
+    return (g_host_ddr[port] & g_host_port[port] & 1 << pin) != 0;
+}
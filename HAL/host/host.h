@@ -0,0 +1,139 @@
+#ifndef MOHG__HAL_HOST_H
+#define MOHG__HAL_HOST_H
+
+/*
+    Host backend of HAL, the firmware runs as a Linux program.
+
+    The time is virtual: it advances only when the firmware sleeps or waits,
+    so the program runs as fast as the host allows and every run is the same.
+    The simulation is configured by environment variables:
+        MOHG_SIM_SECONDS  - the simulated time, then the program exits (60 by default)
+        MOHG_SIM_BUTTONS  - the button presses, e.g. "5:M,10.5:R" (L, M or R at seconds)
+        MOHG_SIM_AMBIENT  - the ambient temperature in degrees Celsius (20 by default)
+        MOHG_SIM_NOISE    - the amplitude of ADC noise in LSB (0 by default)
+        MOHG_SIM_TRACE    - print the state every simulated second, if set
+        MOHG_SIM_FRAMES   - the directory to write every changed image to as PBM
+        MOHG_SIM_PBM      - the file to write the last image to as PBM
+*/
+
+#include <stdint.h>
+
+// the indices of I/O ports
+#define HOST_PORT_A 0
+#define HOST_PORT_B 1
+#define HOST_PORT_C 2
+#define HOST_PORT_D 3
+#define HOST_PORT_AMOUNT 4
+
+// the index of port by its letter, the aliases of configuration.h expand
+#define __HOST_PORT(PORT_LETTER) HOST_PORT_##PORT_LETTER
+#define HOST_PORT(PORT_LETTER) __HOST_PORT(PORT_LETTER)
+
+// the macros take the letter of port, like the AVR ones
+#define __HAL_gpio_write(PORT_LETTER, PIN_NUMBER, STATE) \
+	f_host_gpio_write(HOST_PORT_##PORT_LETTER, PIN_NUMBER, STATE)
+#define __HAL_gpio_write_mask(PORT_LETTER, MASK, VALUE) \
+	f_host_gpio_write_mask(HOST_PORT_##PORT_LETTER, MASK, VALUE)
+#define __HAL_gpio_read(PORT_LETTER, PIN_NUMBER) \
+	f_host_gpio_read(HOST_PORT_##PORT_LETTER, PIN_NUMBER)
+#define __HAL_gpio_direction(PORT_LETTER, PIN_NUMBER, DIRECTION) \
+	f_host_gpio_direction(HOST_PORT_##PORT_LETTER, PIN_NUMBER, DIRECTION)
+
+// set pin to 1 or 0
+#define HAL_gpio_write(PORT_LETTER, PIN_NUMBER, STATE) \
+	__HAL_gpio_write(PORT_LETTER, PIN_NUMBER, STATE)
+
+// set the pins of mask to the bits of value at once
+#define HAL_gpio_write_mask(PORT_LETTER, MASK, VALUE) \
+	__HAL_gpio_write_mask(PORT_LETTER, MASK, VALUE)
+
+// get pin state (non-zero if high)
+#define HAL_gpio_read(PORT_LETTER, PIN_NUMBER) \
+	__HAL_gpio_read(PORT_LETTER, PIN_NUMBER)
+
+// 1 - out, 0 - in
+#define HAL_gpio_direction(PORT_LETTER, PIN_NUMBER, DIRECTION) \
+	__HAL_gpio_direction(PORT_LETTER, PIN_NUMBER, DIRECTION)
+
+// there are no interrupts on host, the drivers finish their work at once
+#define HAL_enable_interrupts()
+#define HAL_disable_interrupts()
+
+// the virtual time passes
+#define HAL_delay_ms(ms) f_host_delay_ms(ms)
+
+
+// GPIO (gpio.c)
+void f_host_gpio_write(uint8_t port, uint8_t pin, uint8_t state);
+void f_host_gpio_write_mask(uint8_t port, uint8_t mask, uint8_t value);
+uint8_t f_host_gpio_read(uint8_t port, uint8_t pin);
+void f_host_gpio_direction(uint8_t port, uint8_t pin, uint8_t direction);
+
+// returns the output latch of pin, the simulation reads heaters with it
+uint8_t f_host_gpio_output(uint8_t port, uint8_t pin);
+
+// waits for the time in virtual time (timers.c)
+void f_host_delay_ms(uint32_t ms);
+
+// moves the virtual time forward by the amount of timer clock periods (timers.c)
+void f_host_advance(uint32_t counts);
+
+
+// the simulated glove (simulation.c)
+
+// reads the configuration from environment
+void f_sim_init(void);
+
+// one timer tick has passed: heat the fingers, press the buttons
+void f_sim_tick(uint32_t ticks);
+
+// returns the ADC value of channel
+uint16_t f_sim_read_ADC(uint8_t channel);
+
+// returns 1 if the button pin is pressed now
+uint8_t f_sim_is_pressed(uint8_t port, uint8_t pin);
+
+
+// the emulated SSD1306 (display.c)
+
+// the statistics of I2C bus as seen by the display
+typedef struct {
+    uint32_t starts;
+    uint32_t stops;
+    // all bytes including address and control bytes
+    uint32_t bytes;
+    uint32_t data_bytes;
+    uint32_t command_bytes;
+    // the bytes of transactions to other addresses
+    uint32_t foreign_bytes;
+    // unknown commands, invalid parameters and control bytes
+    uint32_t errors;
+} display_stats;
+
+// the I2C bus events, the first byte after START is the address byte
+void f_display_start(void);
+void f_display_byte(uint8_t byte);
+void f_display_stop(void);
+
+// returns 1 if the pixel of panel is lit
+uint8_t f_display_pixel(uint8_t x, uint8_t y);
+
+// returns 1 if the image may have changed since the previous call
+uint8_t f_display_is_changed(void);
+
+// returns the statistics
+const display_stats *f_display_get_stats(void);
+
+// returns the time the bytes take on the bus at I2C_FREQ (in microseconds)
+uint32_t f_display_bus_time_us(void);
+
+// prints the image as text
+void f_display_print(void);
+
+// writes the image as binary PBM, returns 0 on failure
+uint8_t f_display_write_pbm(const char *path);
+
+// prints the statistics
+void f_display_print_stats(void);
+
+#endif
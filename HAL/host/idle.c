@@ -0,0 +1,43 @@
+#include "../../idle.h"
+
+#include "../../timers.h"
+#include "host.h"
+
+// the time spent sleeping (in timer clock periods)
+static uint32_t g_idle_sleep_counts = 0;
+// the time the statistics are collected from (in timer clock periods)
+static uint32_t g_idle_window_start = 0;
+
+
+/*
+ * Sleep until an interrupt, unless the deadline (in timer ticks) has come.
+ */
+void f_idle(uint32_t deadline) {
+    // the deadline has come while the tasks were running
+    if ((int32_t)(f_timer_get_ticks() - deadline) >= 0) return;
+
+    // the other drivers finish at once, so only the tick interrupt wakes the CPU
+    uint32_t counts = TIMER_COUNTS_PER_TICK - f_timer_get_counts() % TIMER_COUNTS_PER_TICK;
+
+    g_idle_sleep_counts += counts;
+    f_host_advance(counts);
+}
+
+
+/*
+ * Returns the part of time spent sleeping (in 1/1000) since the previous call.
+ */
+uint16_t f_idle_get_sleep_permille(void) {
+    uint32_t now = f_timer_get_counts();
+
+    uint32_t total = now - g_idle_window_start;
+    uint32_t asleep = g_idle_sleep_counts;
+
+    // new window
+    g_idle_window_start = now;
+    g_idle_sleep_counts = 0;
+
+    if (total == 0) return 0;
+
+    return (uint64_t)asleep * 1000 / total;
+}
@@ -0,0 +1,231 @@
+#include "host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "../../configuration.h"
+#include "../../timers.h"
+
+// the temperature of fingers in the beginning
+#define SIM_INITIAL_TEMPERATURE 24.0
+// the time constant of finger cooling (in seconds)
+#define SIM_COOLING_TIME 30.0
+// the heating rate of finger with heater on (in degrees Celsius per second)
+#define SIM_HEATING_RATE 1.0
+// the duration of button press (in seconds)
+#define SIM_PRESS_DURATION 0.1
+// the maximum amount of scripted button presses
+#define SIM_MAX_PRESSES 64
+
+// the scripted button press
+typedef struct {
+    uint32_t tick;
+    uint8_t pin;
+} sim_press;
+
+// the display updates of firmware that didn't draw (see f_update_display())
+extern uint32_t g_skipped_frames;
+// the part of the last second the firmware has slept (in 1/1000)
+extern uint16_t g_sleep_permille;
+
+// the configuration
+static uint32_t g_sim_end_tick;
+static double g_sim_ambient;
+static uint16_t g_sim_noise;
+static uint8_t g_sim_trace;
+static const char *g_sim_frames;
+static const char *g_sim_pbm;
+
+static sim_press g_sim_presses[SIM_MAX_PRESSES];
+static uint8_t g_sim_press_amount = 0;
+
+// the state of glove
+static uint32_t g_sim_tick = 0;
+static double g_sim_temperatures[THERMISTOR_AMOUNT];
+static uint32_t g_sim_heated_ticks[HEATER_AMOUNT];
+// the maximum amount of heaters on at once, and of heaters turned on at once
+static uint8_t g_sim_max_heaters_on = 0;
+static uint8_t g_sim_max_heaters_switched = 0;
+static uint8_t g_sim_heaters_on = 0;
+static uint32_t g_sim_noise_state = 1;
+
+
+// reads the number from environment
+static double f_sim_env(const char *name, double fallback) {
+    const char *value = getenv(name);
+    return value ? atof(value) : fallback;
+}
+
+// parses the button presses: "<seconds>:<L|M|R>,..."
+static void f_sim_parse_presses(const char *script) {
+    while (script && *script && g_sim_press_amount < SIM_MAX_PRESSES) {
+        char *end;
+        double seconds = strtod(script, &end);
+        if (end == script || *end != ':') break;
+
+        uint8_t pin;
+        switch (end[1]) {
+            case 'L': pin = BUTTON_LEFT_PIN; break;
+            case 'M': pin = BUTTON_MIDDLE_PIN; break;
+            case 'R': pin = BUTTON_RIGHT_PIN; break;
+            default:
+                fprintf(stderr, "MOHG_SIM_BUTTONS: unknown button '%c'\n", end[1]);
+                exit(1);
+        }
+
+        g_sim_presses[g_sim_press_amount].tick = TIMER_TICKS(seconds);
+        g_sim_presses[g_sim_press_amount].pin = pin;
+        g_sim_press_amount++;
+
+        script = end + 2;
+        if (*script == ',') script++;
+    }
+}
+
+// prints the simulated temperatures and the heater duty
+static void f_sim_print_state(void) {
+    printf("%8.3f s:", g_sim_tick / (double)TIMER_TICK_FREQ);
+
+    for (uint8_t i = 0; i < THERMISTOR_AMOUNT; i++) {
+        printf(" %5.2f C", g_sim_temperatures[i]);
+
+        if (i < HEATER_AMOUNT && g_sim_tick)
+            printf(" (%3.0f%%)", 100.0 * g_sim_heated_ticks[i] / g_sim_tick);
+    }
+
+    printf(", asleep %5.1f%%\n", g_sleep_permille / 10.0);
+}
+
+// the simulation is over
+static void f_sim_finish(void) {
+    printf("simulated time, finger temperatures, heater duty and the part of the last second asleep\n");
+    f_sim_print_state();
+
+    printf("heaters: at most %u on at once, at most %u turned on at once\n",
+        g_sim_max_heaters_on,
+        g_sim_max_heaters_switched);
+
+    printf("display:\n");
+    f_display_print();
+    f_display_print_stats();
+    printf("frames: %u display updates skipped, nothing has changed\n", g_skipped_frames);
+
+    if (g_sim_pbm && !f_display_write_pbm(g_sim_pbm)) {
+        fprintf(stderr, "can't write '%s'\n", g_sim_pbm);
+        exit(1);
+    }
+
+    exit(0);
+}
+
+
+void f_sim_init(void) {
+    g_sim_end_tick = TIMER_TICKS(f_sim_env("MOHG_SIM_SECONDS", 60.0));
+    g_sim_ambient = f_sim_env("MOHG_SIM_AMBIENT", 20.0);
+    g_sim_noise = f_sim_env("MOHG_SIM_NOISE", 0.0);
+    g_sim_trace = getenv("MOHG_SIM_TRACE") != NULL;
+    g_sim_frames = getenv("MOHG_SIM_FRAMES");
+    g_sim_pbm = getenv("MOHG_SIM_PBM");
+
+    f_sim_parse_presses(getenv("MOHG_SIM_BUTTONS"));
+
+    for (uint8_t i = 0; i < THERMISTOR_AMOUNT; i++)
+        g_sim_temperatures[i] = SIM_INITIAL_TEMPERATURE;
+}
+
+void f_sim_tick(uint32_t ticks) {
+    g_sim_tick = ticks;
+
+    double dt = 1.0 / TIMER_TICK_FREQ;
+
+    // the peak current
+    uint8_t heaters_on = 0;
+    uint8_t on_amount = 0;
+    uint8_t switched_amount = 0;
+
+    for (uint8_t i = 0; i < HEATER_AMOUNT; i++) {
+        if (!f_host_gpio_output(HOST_PORT(PORT_OUTPUT_DEVICES), HEATER_PINS[i])) continue;
+
+        heaters_on |= 1 << i;
+        on_amount++;
+        if (!(g_sim_heaters_on & 1 << i)) switched_amount++;
+    }
+
+    g_sim_heaters_on = heaters_on;
+    if (on_amount > g_sim_max_heaters_on) g_sim_max_heaters_on = on_amount;
+    if (switched_amount > g_sim_max_heaters_switched) g_sim_max_heaters_switched = switched_amount;
+
+    for (uint8_t i = 0; i < THERMISTOR_AMOUNT; i++) {
+        // the fingers differ a little
+        double rate = SIM_HEATING_RATE * (0.8 + 0.1 * i);
+
+        double t = g_sim_temperatures[i];
+        t -= (t - g_sim_ambient) * dt / SIM_COOLING_TIME;
+
+        if (heaters_on & 1 << i) {
+            t += rate * dt;
+            g_sim_heated_ticks[i]++;
+        }
+
+        g_sim_temperatures[i] = t;
+    }
+
+    if (g_sim_trace && ticks % TIMER_TICK_FREQ == 0) f_sim_print_state();
+
+    // the transactions are over at once, so the image is complete between ticks
+    if (g_sim_frames && f_display_is_changed()) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/frame_%08u.pbm", g_sim_frames, ticks);
+
+        if (!f_display_write_pbm(path)) {
+            fprintf(stderr, "can't write '%s'\n", path);
+            exit(1);
+        }
+    }
+
+    if (ticks >= g_sim_end_tick) f_sim_finish();
+}
+
+uint16_t f_sim_read_ADC(uint8_t channel) {
+    // the divider isn't powered
+    if (!f_host_gpio_output(HOST_PORT(PORT_OUTPUT_DEVICES), OUTPUT_DEVICE_THERMISTORS_SWITCH))
+        return 0;
+
+    // find the finger
+    uint8_t finger = 0;
+    while (finger < THERMISTOR_AMOUNT && THERMISTOR_PINS[finger] != channel) finger++;
+    if (finger == THERMISTOR_AMOUNT) return 0;
+
+    // the resistance of thermistor by B equation (in Kelvins)
+    double t = g_sim_temperatures[finger] + 273.15;
+    double t0 = MOHG_THERMISTOR_T + 273.15;
+    double r = MOHG_THERMISTOR_R * exp(MOHG_THERMISTOR_B * (1.0 / t - 1.0 / t0));
+
+    // the voltage divider, see f_calculate_resistance()
+    double adc = 1023.0 * MOHG_THERMISTOR_DIVIDER_R / (r + MOHG_THERMISTOR_DIVIDER_R);
+
+    // the uniform noise from the linear congruential generator
+    if (g_sim_noise) {
+        g_sim_noise_state = g_sim_noise_state * 1103515245 + 12345;
+        adc += (int32_t)(g_sim_noise_state >> 16) % (2 * g_sim_noise + 1) - g_sim_noise;
+    }
+
+    if (adc < 0) adc = 0;
+    if (adc > 1023) adc = 1023;
+
+    return (uint16_t)(adc + 0.5);
+}
+
+uint8_t f_sim_is_pressed(uint8_t port, uint8_t pin) {
+    if (port != HOST_PORT(PORT_BUTTONS)) return 0;
+
+    for (uint8_t i = 0; i < g_sim_press_amount; i++) {
+        if (g_sim_presses[i].pin == pin &&
+            g_sim_tick >= g_sim_presses[i].tick &&
+            g_sim_tick < g_sim_presses[i].tick + TIMER_TICKS(SIM_PRESS_DURATION))
+            return 1;
+    }
+
+    return 0;
+}
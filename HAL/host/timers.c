@@ -0,0 +1,54 @@
+#include "../../timers.h"
+
+#include "host.h"
+#include "../../pwm.h"
+
+// the virtual time since initialization (in timer clock periods)
+static uint64_t g_host_counts = 0;
+
+
+/*
+ * Initialize the timers
+ */
+void f_init_timers() {
+    // the first driver to be initialized, so the simulation starts here
+    f_sim_init();
+}
+
+/*
+ * Returns the amount of timer ticks since initialization.
+ */
+uint32_t f_timer_get_ticks() {
+    return g_host_counts / TIMER_COUNTS_PER_TICK;
+}
+
+/*
+ * Returns the time since initialization in timer clock periods.
+ */
+uint32_t f_timer_get_counts() {
+    return g_host_counts;
+}
+
+
+void f_host_advance(uint32_t counts) {
+    while (counts) {
+        // the timer clock periods till the next tick
+        uint32_t till_tick = TIMER_COUNTS_PER_TICK - g_host_counts % TIMER_COUNTS_PER_TICK;
+
+        if (till_tick > counts) {
+            g_host_counts += counts;
+            return;
+        }
+
+        g_host_counts += till_tick;
+        counts -= till_tick;
+
+        // the tick interrupt
+        f_pwm_tick();
+        f_sim_tick(g_host_counts / TIMER_COUNTS_PER_TICK);
+    }
+}
+
+void f_host_delay_ms(uint32_t ms) {
+    f_host_advance(ms * (F_CPU / TIMER_PRESCALER / 1000));
+}
@@ -3,8 +3,21 @@
 #include <stdint.h>
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 
 
+// the queue of transactions, the head is being sent now
+static I2C_transaction I2C_queue[I2C_QUEUE_SIZE];
+static volatile uint8_t I2C_queue_head = 0;
+static volatile uint8_t I2C_queue_count = 0;
+
+// the amount of bytes of the head transaction sent after SLA+W
+static volatile uint16_t I2C_position = 0;
+
+// the amount of transactions failed because of NACK or lost arbitration
+volatile uint16_t I2C_error_count = 0;
+
 
 // setup the I2C
 void I2C_setup(void) {
@@ -18,6 +31,9 @@ void I2C_setup(void) {
 
 // create the START condition on the TWI bus
 void I2C_start(void) {
+	// don't break the transaction sent by the interrupt
+	I2C_wait_idle();
+
 	// send the START
 	TWCR = 1 << TWINT | 1 << TWSTA | 1 << TWEN;
 
@@ -64,4 +80,86 @@ void I2C_stop(void) {
 // completely disable the TWI bus
 void I2C_disable(void) {
 	TWCR = 1 << TWINT;
+}
+
+
+// put the transaction into the queue and return immediately
+void I2C_submit(const I2C_transaction *transaction) {
+	// wait for a free slot
+	while (I2C_queue_count == I2C_QUEUE_SIZE);
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		uint8_t tail = (I2C_queue_head + I2C_queue_count) % I2C_QUEUE_SIZE;
+		I2C_queue[tail] = *transaction;
+
+		// the bus is idle, wake it up
+		if (I2C_queue_count++ == 0) {
+			// the STOP of the previous transaction may be still in progress
+			while (TWCR & 1 << TWSTO);
+
+			TWCR = 1 << TWINT | 1 << TWSTA | 1 << TWEN | 1 << TWIE;
+		}
+	}
+}
+
+
+// check if there are queued transactions
+uint8_t I2C_is_busy(void) {
+	return I2C_queue_count != 0;
+}
+
+
+// wait until all queued transactions are sent
+void I2C_wait_idle(void) {
+	while (I2C_queue_count != 0);
+}
+
+
+// the TWI state machine
+ISR(TWI_vect) {
+	I2C_transaction *transaction = &I2C_queue[I2C_queue_head];
+
+	switch (I2C_status) {
+		// START or repeated START has been sent
+		case 0x08:
+		case 0x10:
+			I2C_position = 0;
+			TWDR = I2C_get_addr_byte(transaction->address, 1);
+			TWCR = 1 << TWINT | 1 << TWEN | 1 << TWIE;
+			return;
+
+		// SLA+W or data byte has been acknowledged
+		case 0x18:
+		case 0x28:
+			if (I2C_position < transaction->header_length) {
+				TWDR = transaction->header[I2C_position++];
+				TWCR = 1 << TWINT | 1 << TWEN | 1 << TWIE;
+				return;
+			}
+
+			if (I2C_position - transaction->header_length < transaction->length) {
+				TWDR = transaction->bytes[I2C_position++ - transaction->header_length];
+				TWCR = 1 << TWINT | 1 << TWEN | 1 << TWIE;
+				return;
+			}
+		break;
+
+		// NACK or lost arbitration
+		default:
+			I2C_error_count++;
+		break;
+	}
+
+	// the transaction is over
+	if (transaction->on_complete) transaction->on_complete();
+
+	I2C_queue_head = (I2C_queue_head + 1) % I2C_QUEUE_SIZE;
+	I2C_queue_count--;
+
+	if (I2C_queue_count)
+		// STOP, then START of the next transaction
+		TWCR = 1 << TWINT | 1 << TWEN | 1 << TWIE | 1 << TWSTO | 1 << TWSTA;
+	else
+		// STOP, the interrupt is not needed anymore
+		TWCR = 1 << TWINT | 1 << TWEN | 1 << TWSTO;
 }
\ No newline at end of file
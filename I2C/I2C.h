@@ -6,16 +6,38 @@
 // frequency of I2C bus
 #define I2C_FREQ 400000UL
 
+// the maximum amount of queued transactions
+#define I2C_QUEUE_SIZE 8
+
 // generate the byte with device address and R/W
 // set write to 1, if the application will send data
 #define I2C_get_addr_byte(addr, write) ((addr << 1) | (write ? 0 : 1))
 #define I2C_status (TWSR & 0xF8)
 
+// the write transaction sent by the TWI interrupt:
+// START, SLA+W, header, payload, STOP
+typedef struct {
+	// the address of the slave device
+	uint8_t address;
+	// the bytes sent right after SLA+W (may be NULL)
+	const uint8_t *header;
+	uint8_t header_length;
+	// the bytes sent after the header (may be NULL)
+	const uint8_t *bytes;
+	uint16_t length;
+	// called from the interrupt when the transaction is over (may be NULL)
+	void (*on_complete)(void);
+} I2C_transaction;
+
+// the amount of transactions failed because of NACK or lost arbitration
+extern volatile uint16_t I2C_error_count;
+
 
 // setup the I2C
 void I2C_setup(void);
 
 // create the START condition on the TWI bus
+// waits for the queued transactions to be sent first
 void I2C_start(void);
 
 // wait for TWINT bit to be set
@@ -33,5 +55,16 @@ void I2C_stop(void);
 // completely disable the TWI bus
 void I2C_disable(void);
 
+// put the transaction into the queue and return immediately
+// the buffers must not be changed until the transaction is over
+// waits if the queue is full, interrupts must be enabled
+void I2C_submit(const I2C_transaction *transaction);
+
+// check if there are queued transactions
+uint8_t I2C_is_busy(void);
+
+// wait until all queued transactions are sent
+void I2C_wait_idle(void);
+
 
 #endif
\ No newline at end of file
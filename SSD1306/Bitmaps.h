@@ -1,14 +1,18 @@
 #ifndef __BITMAPS_H
 #define __BITMAPS_H
 
-#include <math.h>
 #include <string.h>
 
+#include <avr/pgmspace.h>
+
+// All bitmaps are stored in flash (PROGMEM), the resolvers return pointers to flash.
+// Use SSD1306_graphics_bitmap_P() to draw them.
+
 // Cyrillic alphabet
 static const uint16_t BMP_CYR_W = 5;
 static const uint16_t BMP_CYR_H = 8;
 
-static const uint8_t *BMP_CYR = 
+static const uint8_t BMP_CYR[] PROGMEM = 
 	"\xfe\x09\x09\x09\xfe" // А
 	"\xff\x89\x89\x89\x71" // Б
 	"\xff\x89\x89\x89\x76" // В
@@ -47,7 +51,7 @@ static const uint8_t *BMP_CYR =
 static const uint16_t BMP_NUMBERS_W = 5;
 static const uint16_t BMP_NUMBERS_H = 8;
 
-static const uint8_t *BMP_NUMBERS = 
+static const uint8_t BMP_NUMBERS[] PROGMEM = 
 	"\x7e\x81\x81\x81\x7e" // 0
 	"\x00\x04\x02\xFF\x00" // 1
 	"\xC6\xA1\x91\x89\x86" // 2
@@ -64,7 +68,7 @@ static const uint8_t *BMP_NUMBERS =
 static const uint16_t BMP_SYMBOLS_W = 4;
 static const uint16_t BMP_SYMBOLS_H = 8;
 
-static const uint8_t *BMP_SYMBOLS = 
+static const uint8_t BMP_SYMBOLS[] PROGMEM = 
 	"\x00\x66\x66\x00" // :
 	"\x00\xc0\xc0\x00" // .
 	"\x08\x08\x08\x08" // -
@@ -76,12 +80,12 @@ static const uint8_t *BMP_SYMBOLS =
 // invalid character (4x8)
 static const uint16_t BMP_INAVLID_W = 4;
 static const uint16_t BMP_INAVLID_H = 8;
-static const uint8_t *BMP_INAVLID = "\xFF\x81\x81\xFF";
+static const uint8_t BMP_INAVLID[] PROGMEM = "\xFF\x81\x81\xFF";
 
 // logo
 static const uint16_t BMP_LOGO_W = 128;
 static const uint16_t BMP_LOGO_H = 32;
-static const uint8_t *BMP_LOGO = 
+static const uint8_t BMP_LOGO[] PROGMEM = 
 	"\x00\x00\x70\x10\x10\x10\x10\xf0"
 	"\xf0\x10\x10\x10\x10\x70\x00\x80"
 	"\x80\x80\x80\x00\x00\x00\x80\x80"
@@ -150,7 +154,7 @@ static const uint8_t *BMP_LOGO =
 // tepglove
 static const uint16_t BMP_POLY_W = 32;
 static const uint16_t BMP_POLY_H = 32;
-static const uint8_t *BMP_POLY = 
+static const uint8_t BMP_POLY[] PROGMEM = 
 	"\x00\x00\x80\x40\xa0\x40\xa8\x14\xa8\x44\xaa\x54\x0a\x55\x2a"
 	"\x55\x2a\x55\x2a\x55\xaa\x54\xaa\x54\xa8\x50\xa0\x40\x80\x00"
 	"\x00\x00\xa0\x54\x8a\x51\x2a\x44\x2a\x05\x02\x01\x00\x00\x00"
@@ -161,6 +165,29 @@ static const uint8_t *BMP_POLY =
 	"\x49\x22\x54\x88\x24\x88\x54\xa8\x44\x92\x44\x2a\x51\x2a\x04"
 	"\x2a\x04\x08\x02\x00\x00\x00\x00";
 
+// Widths of the symbols of default resolver, indexed by code point (CP866) from ' '.
+// The symbols outside of the table are invalid.
+#define BMP_DEFAULT_WIDTHS_FIRST ' '
+static const uint8_t BMP_DEFAULT_WIDTHS[] PROGMEM = {
+	3, 3, 3, 6, 5, 5, 6, 2, 2, 2, 5, 5, 3, 5, 2, 3, // ' ' - '/'
+	5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 3, 3, 5, 5, 5, 5, // '0' - '?'
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, // '@' - 'O'
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, // 'P' - '_'
+	4, 4, 4, 4, 8, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, // '`' - 'o'
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, // 'p' - DEL
+	5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, // 'А' - 'П'
+	5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, // 'Р' - 'Я'
+};
+
+// Returns the width of symbol drawn by the default resolver, without resolving the bitmap
+uint8_t BMP_default_symbol_width(char symbol) {
+	uint8_t index = (uint8_t)symbol - (uint8_t)BMP_DEFAULT_WIDTHS_FIRST;
+
+	if (index >= sizeof(BMP_DEFAULT_WIDTHS)) return BMP_INAVLID_W;
+
+	return pgm_read_byte(&BMP_DEFAULT_WIDTHS[index]);
+}
+
 // Sign resolver
 uint8_t *BMP_sign_resolver(char symbol, uint16_t *w, uint16_t *h) {
 	// this sign is unsupported
@@ -168,82 +195,49 @@ uint8_t *BMP_sign_resolver(char symbol, uint16_t *w, uint16_t *h) {
 		*w = BMP_INAVLID_W;
 		*h = BMP_INAVLID_H;
 
-		return BMP_INAVLID;
+		return (uint8_t *)BMP_INAVLID;
 	}
 
 	*h = 8;
 
-	// switching, because width of signs differ
-	switch (symbol) {
-		case 'd':
-			*w = 8;
-			break;
-		case '#':
-		case '&':
-			*w = 6;
-		break;
-		case '*':
-		case '+':
-		case '-':
-		case '<':
-		case '=':
-		case '>':
-		case '?':
-		case '$':
-		case '%':
-			*w = 5;
-		break;
-		case '!':
-		case '"':
-		case '/':
-		case ':':
-		case ';':
-		case ',':
-			*w = 3;
-		break;
-		case '\'':
-		case '(':
-		case ')':
-		case '.':
-			*w = 2;
-		break;
-	}
+	// widths of signs differ
+	*w = BMP_default_symbol_width(symbol);
 
 	// returning the bytes
 	switch (symbol) {
 		// w = 8
-		case 'd': return "\x02\x05\x02\x00\x7e\x81\x81\x81";
+		case 'd': return (uint8_t *)PSTR("\x02\x05\x02\x00\x7e\x81\x81\x81");
 		// w = 6
-		case '#': return "\x24\xff\x24\x24\xff\x24";
-		case '&': return "\x72\x8d\x8d\x55\x25\xd2";
+		case '#': return (uint8_t *)PSTR("\x24\xff\x24\x24\xff\x24");
+		case '&': return (uint8_t *)PSTR("\x72\x8d\x8d\x55\x25\xd2");
 		// w = 5
-		case '*': return "\x2a\x1c\x08\x1c\x2a";
-		case '+': return "\x08\x08\x3e\x08\x08";
-		case '-': return "\x08\x08\x08\x08\x08";
-		case '<': return "\x08\x14\x24\x22\x41";
-		case '=': return "\x14\x14\x14\x14\x14";
-		case '>': return "\x41\x22\x14\x14\x08";
-		case '?': return "\x02\x01\xb1\x09\x06";
-		case '$': return "\x44\x4a\xff\x4a\x32";
-		case '%': return "\x83\x63\x18\xc6\xc1";
+		case '*': return (uint8_t *)PSTR("\x2a\x1c\x08\x1c\x2a");
+		case '+': return (uint8_t *)PSTR("\x08\x08\x3e\x08\x08");
+		case '-': return (uint8_t *)PSTR("\x08\x08\x08\x08\x08");
+		case '<': return (uint8_t *)PSTR("\x08\x14\x24\x22\x41");
+		case '=': return (uint8_t *)PSTR("\x14\x14\x14\x14\x14");
+		case '>': return (uint8_t *)PSTR("\x41\x22\x14\x14\x08");
+		case '?': return (uint8_t *)PSTR("\x02\x01\xb1\x09\x06");
+		case '$': return (uint8_t *)PSTR("\x44\x4a\xff\x4a\x32");
+		case '%': return (uint8_t *)PSTR("\x83\x63\x18\xc6\xc1");
 		// w = 3
-		case '!': return "\x1e\xbf\x1e";
-		case '"': return "\x03\x00\x03";
-		case '/': return "\xc0\x3c\x03";
-		case ':': return "\x00\x42\x00";
-		case ';': return "\x00\xa2\x40";
-		case ',': return "\x40\x20\xc0";
+		case '!': return (uint8_t *)PSTR("\x1e\xbf\x1e");
+		case '"': return (uint8_t *)PSTR("\x03\x00\x03");
+		case '/': return (uint8_t *)PSTR("\xc0\x3c\x03");
+		case ':': return (uint8_t *)PSTR("\x00\x42\x00");
+		case ';': return (uint8_t *)PSTR("\x00\xa2\x40");
+		case ',': return (uint8_t *)PSTR("\x40\x20\xc0");
 		// w = 2
-		case '\'': return "\x01\x03";
-		case '(': return "\x7e\x81";
-		case ')': return "\x81\x7e";
-		case '.': return "\xc0\xc0";
+		case '\'': return (uint8_t *)PSTR("\x01\x03");
+		case '(': return (uint8_t *)PSTR("\x7e\x81");
+		case ')': return (uint8_t *)PSTR("\x81\x7e");
+		case '.': return (uint8_t *)PSTR("\xc0\xc0");
 
 		default:
 			*w = BMP_INAVLID_W;
 			*h = BMP_INAVLID_H;
 
-			return BMP_INAVLID;
+			return (uint8_t *)BMP_INAVLID;
 	}
 }
 
@@ -254,21 +248,21 @@ uint8_t *BMP_default_symbol_resolver(char symbol, uint16_t *w, uint16_t *h) {
 		*w = BMP_NUMBERS_W;
 		*h = BMP_NUMBERS_H;
 
-		return BMP_NUMBERS + BMP_NUMBERS_W * ((uint16_t)symbol - (uint16_t)'0');
+		return (uint8_t *)BMP_NUMBERS + BMP_NUMBERS_W * ((uint16_t)symbol - (uint16_t)'0');
 	}
 	// cyrillic alphabet
-	else if (symbol >= 'А' && symbol <= 'Я') {
+	else if ((uint8_t)symbol >= (uint8_t)'А' && (uint8_t)symbol <= (uint8_t)'Я') {
 		*w = BMP_CYR_W;
 		*h = BMP_CYR_H;
 
-		return BMP_CYR + BMP_CYR_W * ((uint16_t)symbol - (uint16_t)'А');
+		return (uint8_t *)BMP_CYR + BMP_CYR_W * ((uint16_t)symbol - (uint16_t)'А');
 	}
 	// space
 	else if (symbol == ' ') {
 		*w = 3;
 		*h = 8;
 
-		return "\x00\x00\x00";
+		return (uint8_t *)PSTR("\x00\x00\x00");
 	}
 	// sign
 	else {
@@ -297,9 +291,9 @@ void BMP_calculate_string_dimensions(
 			continue;
 		}
 
-		// get the bitmap for the symbol
+		// get the size of the symbol
 		uint16_t w, h;
-		uint8_t* bmp = (*resolver)(str[i], &w, &h);
+		(*resolver)(str[i], &w, &h);
 
 		// move the cursor
 		x += w + 1;
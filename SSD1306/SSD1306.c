@@ -1,13 +1,119 @@
 #include "SSD1306.h"
 
 #include <string.h>
-#include <math.h>
+
+#include <avr/pgmspace.h>
 
 #include "../I2C/I2C.h"
 
+#ifdef SSD1306_PAGE_STREAMING
+
+// the amount of strips in a page
+#define SSD1306_STRIPS (__SSD1306_WIDTH / SSD1306_STRIP_WIDTH)
+
+// the operations of display list, the operation byte is followed by the arguments
+#define SSD1306_OP_FILL			0	// x1, y1, x2, y2, color
+#define SSD1306_OP_RECTANGLE	1	// x1, y1, x2, y2, color
+#define SSD1306_OP_BITMAP		2	// x, y, w, h, mode | SSD1306_OP_FLASH, pointer
+#define SSD1306_OP_TEXT			3	// x, y, resolver, characters and 0
+// the bitmap is stored in flash
+#define SSD1306_OP_FLASH		0x80
+
+// the symbol resolver of text operation
+typedef uint8_t*(*SSD1306_resolver)(char, uint16_t*, uint16_t*);
+
+// the display list of the frame, the drawing functions append to it
+uint8_t SSD1306_display_list[SSD1306_DISPLAY_LIST_SIZE];
+uint16_t SSD1306_display_list_length = 0;
+uint16_t SSD1306_display_list_peak = 0;
+uint16_t SSD1306_display_list_overflows = 0;
+
+// the color the frame is filled with before the display list
+uint8_t SSD1306_background = SSD1306_BLACK;
+
+// the hashes of the background and the operations drawing to the strips on the display
+// the strip is sent only if its hash has changed
+uint16_t SSD1306_strip_hashes[__SSD1306_PAGES][SSD1306_STRIPS];
+// 1 if the contents of display are unknown
+uint8_t SSD1306_is_invalid = 1;
+
+// the strips of columns and the command streams selecting their windows
+// one strip is rasterized while the other one is sent from the I2C interrupt
+uint8_t SSD1306_strip_buffers[2][SSD1306_STRIP_WIDTH];
+uint8_t SSD1306_strip_commands[2][7];
+uint8_t SSD1306_strip_buffer = 0;
+
+// the strip being rasterized
+uint8_t *SSD1306_strip = SSD1306_strip_buffers[0];
+uint8_t SSD1306_strip_page = 0;
+uint8_t SSD1306_strip_x = 0;
+
+// the amount of strips queued and sent, they overflow
+// each one is written by one side only, so no atomic access is needed
+volatile uint8_t SSD1306_strips_queued = 0;
+volatile uint8_t SSD1306_strips_sent = 0;
+
+// the window the drawing is clipped to, the bytes of strip
+#define SSD1306_CLIP_X1		SSD1306_strip_x
+#define SSD1306_CLIP_X2		(SSD1306_strip_x + SSD1306_STRIP_WIDTH - 1)
+#define SSD1306_CLIP_PAGE1	SSD1306_strip_page
+#define SSD1306_CLIP_PAGE2	SSD1306_strip_page
+#define SSD1306_BYTE(page, x)	(SSD1306_strip + (x) - SSD1306_strip_x)
+// 1 if the column is left of the window or the page is above it
+#define SSD1306_CLIP_LEFT_OF(x)		((x) < SSD1306_strip_x)
+#define SSD1306_CLIP_ABOVE(page)	((page) < SSD1306_strip_page)
+
+#else
+
 // the framebuffer of the display
-uint8_t *SSD1306_framebuffer;
-uint16_t SSD1306_framebuffer_size = 0;
+uint8_t SSD1306_framebuffer[__SSD1306_WIDTH * __SSD1306_HEIGHT / 8];
+const uint16_t SSD1306_framebuffer_size = sizeof(SSD1306_framebuffer);
+
+// the span of columns written since the last render, for every page
+// the page is clean if x1 > x2
+uint8_t SSD1306_dirty_x1[__SSD1306_PAGES];
+uint8_t SSD1306_dirty_x2[__SSD1306_PAGES];
+
+#ifdef SSD1306_SHADOW
+// the bytes the display shows, the dirty spans are compared to them
+// a frame is drawn from scratch, so the drawing alone can't tell what has changed
+uint8_t SSD1306_shadow[__SSD1306_WIDTH * __SSD1306_HEIGHT / 8];
+// 1 if the contents of display are unknown
+uint8_t SSD1306_is_invalid = 1;
+#endif
+
+// the command streams selecting the window of every page
+// they are sent from the I2C interrupt, so they must live until the render is over
+uint8_t SSD1306_page_commands[__SSD1306_PAGES][7];
+
+// the window the drawing is clipped to, the bytes of framebuffer
+#define SSD1306_CLIP_X1		0
+#define SSD1306_CLIP_X2		(__SSD1306_WIDTH - 1)
+#define SSD1306_CLIP_PAGE1	0
+#define SSD1306_CLIP_PAGE2	(__SSD1306_PAGES - 1)
+#define SSD1306_BYTE(page, x)	(SSD1306_framebuffer + __SSD1306_WIDTH * (page) + (x))
+// the window begins at the first column and page, nothing is left of it or above it
+#define SSD1306_CLIP_LEFT_OF(x)		0
+#define SSD1306_CLIP_ABOVE(page)	0
+
+#endif
+
+// the amount of bytes sent over I2C by the last render
+uint16_t SSD1306_bytes_sent = 0;
+
+// count the bytes visited by the drawing kernels
+#ifdef SSD1306_KERNEL_COUNTERS
+uint32_t SSD1306_kernel_bytes = 0;
+#define SSD1306_COUNT_BYTES(amount) (SSD1306_kernel_bytes += (amount))
+#else
+#define SSD1306_COUNT_BYTES(amount)
+#endif
+
+// the active render mode
+uint8_t SSD1306_render_mode = SSD1306_RENDER_FULL;
+
+// the control byte of data transactions
+const uint8_t SSD1306_DATA_HEADER[] = { 1 << 6 };
 
 // This sequence is sent when display is initializing
 const char SETUP_SEQUENCE[] = {
@@ -39,19 +145,122 @@ void SSD1306_setup(void) {
 	// SLA+W
 	I2C_send_one(I2C_get_addr_byte(__SSD1306_ADDRESS, 1));
 
-	// send the setup sequence
-	for (int i = 0; i < sizeof(SETUP_SEQUENCE) / sizeof(SETUP_SEQUENCE[0]); i++) {
-		SSD1306_send_command(SETUP_SEQUENCE[i], 0);
-	}
+	// send the setup sequence as one stream of commands
+	I2C_send_one(0x00);
+	I2C_send((const uint8_t *)SETUP_SEQUENCE, sizeof(SETUP_SEQUENCE));
 
 	// stop the I2C
 	I2C_stop();
 
-	// create the buffer
-	SSD1306_framebuffer_size = __SSD1306_WIDTH * __SSD1306_HEIGHT / 8;
-	SSD1306_framebuffer = malloc(SSD1306_framebuffer_size);
+	// the contents of display are unknown, so everything is dirty
+	SSD1306_invalidate();
+}
+
+
+// send one byte over I2C and count it
+static void SSD1306_send_byte(uint8_t byte) {
+	I2C_send_one(byte);
+	SSD1306_bytes_sent++;
+}
+
+
+// put the write transaction into the I2C queue and count its bytes
+static void SSD1306_queue(
+	const uint8_t *header,
+	uint8_t header_length,
+	const uint8_t *bytes,
+	uint16_t length,
+	void (*on_complete)(void))
+{
+	I2C_transaction transaction = {
+		.address = __SSD1306_ADDRESS,
+		.header = header,
+		.header_length = header_length,
+		.bytes = bytes,
+		.length = length,
+		.on_complete = on_complete,
+	};
+
+	I2C_submit(&transaction);
+
+	// SLA+W, header and payload
+	SSD1306_bytes_sent += 1 + header_length + length;
+}
+
+
+// write the command stream selecting columns x1..x2 and pages p1..p2 to the buffer
+// returns the amount of bytes written
+static uint8_t SSD1306_window_commands(
+	uint8_t *commands,
+	uint8_t x1,
+	uint8_t x2,
+	uint8_t p1,
+	uint8_t p2)
+{
+	// one control byte for the whole stream of commands
+	commands[0] = 0x00;
+
+	commands[1] = __SSD1306_CMD__Column_Address_Set;
+	commands[2] = x1;
+	commands[3] = x2;
+
+	commands[4] = __SSD1306_CMD__Page_Address_Set;
+	commands[5] = p1;
+	commands[6] = p2;
+
+	return 7;
+}
+
+
+// queue the data bytes, split into transactions of SSD1306_STREAM_CHUNK bytes
+// on_complete is called when the last of them is over (may be NULL)
+static void SSD1306_queue_data(const uint8_t *bytes, uint16_t length, void (*on_complete)(void)) {
+	while (length) {
+		uint16_t chunk = length;
+		if (SSD1306_STREAM_CHUNK && chunk > SSD1306_STREAM_CHUNK)
+			chunk = SSD1306_STREAM_CHUNK;
+
+		SSD1306_queue(
+			SSD1306_DATA_HEADER,
+			sizeof(SSD1306_DATA_HEADER),
+			bytes,
+			chunk,
+			chunk == length ? on_complete : 0);
+
+		bytes += chunk;
+		length -= chunk;
+	}
+}
+
+
+#ifdef SSD1306_PAGE_STREAMING
+
+// the strips are compared by their operations, there is nothing to mark
+static void SSD1306_mark_dirty(uint8_t page, uint8_t x1, uint8_t x2) {
+	(void)page;
+	(void)x1;
+	(void)x2;
 }
 
+#else
+
+// mark the columns x1..x2 of the page as dirty
+static void SSD1306_mark_dirty(uint8_t page, uint8_t x1, uint8_t x2) {
+	if (x1 < SSD1306_dirty_x1[page]) SSD1306_dirty_x1[page] = x1;
+	if (x2 > SSD1306_dirty_x2[page]) SSD1306_dirty_x2[page] = x2;
+}
+
+
+// mark all pages as clean
+static void SSD1306_mark_clean(void) {
+	for (uint8_t page = 0; page < __SSD1306_PAGES; page++) {
+		SSD1306_dirty_x1[page] = __SSD1306_WIDTH - 1;
+		SSD1306_dirty_x2[page] = 0;
+	}
+}
+
+#endif
+
 
 // send a single command without arguments to display
 // if issue_start is 1 then the START and STOP conditions will be sent
@@ -65,109 +274,185 @@ void SSD1306_send_command(uint8_t command, int issue_start) {
 	}
 
 	// identify the control byte
-	I2C_send_one(1 << 7);
+	SSD1306_send_byte(1 << 7);
 
 	// send the byte with command
-	I2C_send_one(command);
+	SSD1306_send_byte(command);
 
 	// stop the I2C
 	if (issue_start) I2C_stop();
 }
 
 
-// send framebuffer to display
+// set the render mode (SSD1306_RENDER_FULL or SSD1306_RENDER_DIRTY)
+void SSD1306_set_render_mode(uint8_t mode) {
+	SSD1306_render_mode = mode;
+}
+
+
+// send framebuffer to display using the active render mode
 void SSD1306_render(void) {
-	// start the I2C
-	I2C_start();
+	if (SSD1306_render_mode == SSD1306_RENDER_DIRTY)
+		SSD1306_render_dirty();
+	else
+		SSD1306_render_full();
+}
 
-	// SLA+W
-	I2C_send_one(I2C_get_addr_byte(__SSD1306_ADDRESS, 1));
+
+#ifndef SSD1306_PAGE_STREAMING
+
+// mark the whole framebuffer as dirty, the display is not compared to
+void SSD1306_invalidate(void) {
+	for (uint8_t page = 0; page < __SSD1306_PAGES; page++) {
+		SSD1306_dirty_x1[page] = 0;
+		SSD1306_dirty_x2[page] = __SSD1306_WIDTH - 1;
+	}
+
+#ifdef SSD1306_SHADOW
+	SSD1306_is_invalid = 1;
+#endif
+}
+
+
+// send the whole framebuffer to display
+void SSD1306_render_full(void) {
+	// the previous frame may still be in the queue
+	SSD1306_wait();
+
+	// new frame
+	SSD1306_bytes_sent = 0;
 
 	// go to beginning
-	SSD1306_send_command(__SSD1306_CMD__Column_Address_Set, 0);
-	SSD1306_send_command(0x00, 0);
-	SSD1306_send_command(__SSD1306_WIDTH - 1, 0);
+	uint8_t length = SSD1306_window_commands(
+		SSD1306_page_commands[0],
+		0,
+		__SSD1306_WIDTH - 1,
+		0,
+		__SSD1306_PAGES - 1);
+	SSD1306_queue(SSD1306_page_commands[0], length, 0, 0, 0);
 
-	SSD1306_send_command(__SSD1306_CMD__Page_Address_Set, 0);
-	SSD1306_send_command(0x00, 0);
-	SSD1306_send_command(__SSD1306_HEIGHT / 8 - 1, 0);
+	// the window covers the whole display, so the framebuffer goes as one stream
+	SSD1306_queue_data(SSD1306_framebuffer, SSD1306_framebuffer_size, 0);
 
-	// stop the I2C
-	I2C_stop();
+	// the display is up to date
+#ifdef SSD1306_SHADOW
+	memcpy(SSD1306_shadow, SSD1306_framebuffer, SSD1306_framebuffer_size);
+	SSD1306_is_invalid = 0;
+#endif
+	SSD1306_mark_clean();
+}
 
 
+// send only the dirty spans of framebuffer, trimmed to the columns that differ
+// from the display with SSD1306_SHADOW
+void SSD1306_render_dirty(void) {
+	// the previous frame may still be in the queue
+	SSD1306_wait();
 
-	//I2C_send_one(SSD1306_framebuffer[i]);
-	for (int i = 0; i < SSD1306_framebuffer_size / 16; i++) {
-		// start the I2C
-		I2C_start();
+	// new frame
+	SSD1306_bytes_sent = 0;
 
-		// SLA+W
-		I2C_send_one(I2C_get_addr_byte(__SSD1306_ADDRESS, 1));
+	for (uint8_t page = 0; page < __SSD1306_PAGES; page++) {
+		uint8_t x1 = SSD1306_dirty_x1[page];
+		uint8_t x2 = SSD1306_dirty_x2[page];
+
+		// nothing to send
+		if (x1 > x2) continue;
+
+		const uint8_t *line = SSD1306_framebuffer + __SSD1306_WIDTH * page;
+
+#ifdef SSD1306_SHADOW
+		uint8_t *shown = SSD1306_shadow + __SSD1306_WIDTH * page;
+
+		// the columns drawn back as they were are trimmed, only the net change is sent
+		if (!SSD1306_is_invalid) {
+			while (x1 <= x2 && line[x1] == shown[x1]) x1++;
+			if (x1 > x2) continue;
+			while (line[x2] == shown[x2]) x2--;
+		}
 
-		// we're gonna send only data today
-		I2C_send_one(1 << 6);
+		memcpy(shown + x1, line + x1, x2 - x1 + 1);
+#endif
 
-		I2C_send(SSD1306_framebuffer + 16 * i, 16);
+		// the window of dirty columns in this page
+		uint8_t length = SSD1306_window_commands(
+			SSD1306_page_commands[page],
+			x1,
+			x2,
+			page,
+			page);
+		SSD1306_queue(SSD1306_page_commands[page], length, 0, 0, 0);
 
-		// stop the I2C
-		I2C_stop();
+		// data only
+		SSD1306_queue_data(line + x1, x2 - x1 + 1, 0);
 	}
 
+	// the display is up to date
+#ifdef SSD1306_SHADOW
+	SSD1306_is_invalid = 0;
+#endif
+	SSD1306_mark_clean();
 }
 
+#endif
 
-// fill the screen
-void SSD1306_graphics_fill(int color) {
-	memset(SSD1306_framebuffer, color ? 0xFF : 0x00, SSD1306_framebuffer_size);
+
+// check if the last render is still being sent
+uint8_t SSD1306_is_busy(void) {
+	return I2C_is_busy();
 }
 
-// set the pixel
-void SSD1306_graphics_set(uint8_t x, uint8_t y, int color) {
-	// check OOB
-	if (x >= __SSD1306_WIDTH) return;
-	if (y >= __SSD1306_HEIGHT) return;
 
-	int16_t line = y / 8;
-	int16_t bit = y % 8;
+// wait until the last render is sent
+void SSD1306_wait(void) {
+	I2C_wait_idle();
+}
 
-	uint16_t offset = __SSD1306_WIDTH * line + x;
 
-	if (color)
-		SSD1306_framebuffer[offset] |= 1 << bit;
-	else
-		SSD1306_framebuffer[offset] &= ~(1 << bit);
-}
+// apply the mask to the columns x1..x2 of the page
+// the bits of mask are set to color, the other bits stay as they are
+static void SSD1306_fill_span(uint8_t page, uint8_t x1, uint8_t x2, uint8_t mask, int color) {
+	// the bytes of columns x1..x2
+	uint8_t *line = SSD1306_BYTE(page, x1);
+	uint8_t last = x2 - x1;
 
-// draws the horizontal line
-void SSD1306_graphics_hline(uint8_t x1, uint8_t x2, uint8_t y, int color) {
-	for (; x1 != x2; x1 += (x1 > x2 ? -1 : 1))
-		SSD1306_graphics_set(x1, y, color);
-	if (x2 >= __SSD1306_WIDTH) return;
+	SSD1306_COUNT_BYTES(last + 1);
 
-	SSD1306_graphics_set(x2, y, color);
-}
+	// whole bytes
+	if (mask == 0xFF) {
+		uint8_t value = color ? 0xFF : 0x00;
+		uint8_t first = 0;
 
-// draws the vertical line
-void SSD1306_graphics_vline(uint8_t y1, uint8_t y2, uint8_t x, int color) {
-	for (; y1 != y2; y1 += (y1 > y2 ? -1 : 1))
-		SSD1306_graphics_set(x, y1, color);
-	if (y2 >= __SSD1306_HEIGHT) return;
+		// skip the columns that already have this color
+		while (first <= last && line[first] == value) first++;
+		if (first > last) return;
+		while (line[last] == value) last--;
 
-	SSD1306_graphics_set(x, y2, color);
-}
+		memset(line + first, value, last - first + 1);
+		SSD1306_mark_dirty(page, x1 + first, x1 + last);
+		return;
+	}
 
-// draws the rectangle
-void SSD1306_graphics_rectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, int color) {
-	SSD1306_graphics_hline(x1, x2, y1, color);
-	SSD1306_graphics_hline(x1, x2, y2, color);
+	// the changed columns
+	uint8_t first = 0xFF, changed = 0;
+
+	for (uint8_t i = 0; i <= last; i++) {
+		uint8_t old_value = line[i];
+		uint8_t new_value = color ? old_value | mask : old_value & ~mask;
 
-	SSD1306_graphics_vline(y1, y2, x1, color);
-	SSD1306_graphics_vline(y1, y2, x2, color);
+		if (new_value == old_value) continue;
+
+		line[i] = new_value;
+		if (first == 0xFF) first = i;
+		changed = i;
+	}
+
+	if (first != 0xFF) SSD1306_mark_dirty(page, x1 + first, x1 + changed);
 }
 
-// draws the filled rectangle
-void SSD1306_graphics_filled_rectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, int color) {
+// fill the area from (x1, y1) to (x2, y2) inclusive, the corners may go in any order
+// the masks of pages are built once and applied to the whole span of columns
+static void SSD1306_raster_fill_area(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, int color) {
 	if (x1 > x2) {
 		uint8_t c = x2;
 		x2 = x1;
@@ -179,43 +464,123 @@ void SSD1306_graphics_filled_rectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8
 		y1 = c;
 	}
 
-	for (uint8_t x = x1; x <= x2; x++)
-		for (uint8_t y = y1; y <= y2; y++)
-			SSD1306_graphics_set(x, y, color);
+	// out of bounds
+	if (x1 > SSD1306_CLIP_X2 || SSD1306_CLIP_LEFT_OF(x2) || y1 >= __SSD1306_HEIGHT) return;
+	if (SSD1306_CLIP_LEFT_OF(x1)) x1 = SSD1306_CLIP_X1;
+	if (x2 > SSD1306_CLIP_X2) x2 = SSD1306_CLIP_X2;
+	if (y2 >= __SSD1306_HEIGHT) y2 = __SSD1306_HEIGHT - 1;
+
+	uint8_t first_page = y1 / 8;
+	uint8_t last_page = y2 / 8;
+
+	for (uint8_t page = first_page; page <= last_page; page++) {
+		if (SSD1306_CLIP_ABOVE(page) || page > SSD1306_CLIP_PAGE2) continue;
+
+		uint8_t mask = 0xFF;
+
+		// the first and the last pages may be covered partially
+		if (page == first_page) mask &= 0xFF << (y1 % 8);
+		if (page == last_page) mask &= 0xFF >> (7 - y2 % 8);
+
+		SSD1306_fill_span(page, x1, x2, mask, color);
+	}
 }
 
-// draws the bitmap
-void SSD1306_graphics_bitmap(const uint8_t *bmp, uint8_t w, uint8_t h, uint8_t x, uint8_t y) {
-	for (uint8_t bx = 0; bx < w; bx++) {
-		// position of BMP pixel on screen
-		uint8_t fx = x + bx;
+// draws the rectangle outline
+static void SSD1306_raster_rectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, int color) {
+	SSD1306_raster_fill_area(x1, y1, x2, y1, color);
+	SSD1306_raster_fill_area(x1, y2, x2, y2, color);
 
-		// out of bounds
-		if (fx >= __SSD1306_WIDTH) break;
+	SSD1306_raster_fill_area(x1, y1, x1, y2, color);
+	SSD1306_raster_fill_area(x2, y1, x2, y2, color);
+}
 
-		for (uint8_t by = 0; by < h; by++) {
-			uint8_t fy = y + by;
+// write the bits to the byte of framebuffer through the mask using the blit mode
+// returns 1 if the byte has changed
+static inline uint8_t SSD1306_blit_byte(uint8_t *dst, uint8_t bits, uint8_t mask, uint8_t mode) {
+	uint8_t old_value = *dst;
+	uint8_t new_value;
 
-			// out of bounds
-			if (fy >= __SSD1306_HEIGHT) break;
+	switch (mode) {
+		case SSD1306_BLIT_OR: new_value = old_value | bits; break;
+		case SSD1306_BLIT_XOR: new_value = old_value ^ bits; break;
+		default: new_value = (old_value & ~mask) | bits; break;
+	}
+
+	*dst = new_value;
+
+	return new_value != old_value;
+}
+
+// draws the bitmap stored in RAM or in flash
+// the bitmap is copied byte by byte, the columns of bitmap are shifted
+// across two pages if y is not a multiple of 8
+static void SSD1306_raster_bitmap(
+	const uint8_t *bmp,
+	uint8_t w,
+	uint8_t h,
+	uint8_t x,
+	uint8_t y,
+	uint8_t mode,
+	uint8_t from_flash)
+{
+	// out of bounds
+	if (!w || x > SSD1306_CLIP_X2 || x + w <= SSD1306_CLIP_X1 || y >= __SSD1306_HEIGHT) return;
+
+	// the visible columns
+	uint8_t bx1 = SSD1306_CLIP_LEFT_OF(x) ? SSD1306_CLIP_X1 - x : 0;
+	uint8_t bx2 = w - 1;
+	if (x + w - 1 > SSD1306_CLIP_X2) bx2 = SSD1306_CLIP_X2 - x;
+
+	// the position of bitmap rows in the pages of framebuffer
+	uint8_t page = y / 8;
+	uint8_t shift = y % 8;
+
+	for (uint8_t b_line = 0; b_line * 8 < h && page < __SSD1306_PAGES; b_line++, page++) {
+		// the rows of this line of bitmap
+		uint8_t rows = h - b_line * 8;
+		uint8_t b_mask = rows >= 8 ? 0xFF : (1 << rows) - 1;
+
+		// the line goes to the current page and, if shifted, to the next one
+		uint8_t mask_lo = b_mask << shift;
+		uint8_t mask_hi = shift ? b_mask >> (8 - shift) : 0;
+		if (page + 1 > SSD1306_CLIP_PAGE2 || SSD1306_CLIP_ABOVE(page + 1)) mask_hi = 0;
+
+		// the pages outside of the clip window are skipped
+		uint8_t is_lo = !SSD1306_CLIP_ABOVE(page) && page <= SSD1306_CLIP_PAGE2;
+		if (!is_lo && !mask_hi) continue;
 
-			// get pixel value
-			uint8_t b_line = by / 8;
-			uint8_t b_bit = by % 8;
+		const uint8_t *src = bmp + b_line * w;
+		uint8_t *dst_lo = is_lo ? SSD1306_BYTE(page, x + bx1) : 0;
+		uint8_t *dst_hi = mask_hi ? SSD1306_BYTE(page + 1, x + bx1) : 0;
 
-			uint8_t b_val = bmp[b_line * w + bx] & (1 << b_bit);
+		// the changed columns of both pages
+		uint8_t lo_x1 = 0xFF, lo_x2 = 0;
+		uint8_t hi_x1 = 0xFF, hi_x2 = 0;
 
-			SSD1306_graphics_set(
-				fx,
-				fy,
-				b_val);
+		SSD1306_COUNT_BYTES((bx2 - bx1 + 1) * ((dst_lo ? 1 : 0) + (dst_hi ? 1 : 0)));
 
+		for (uint8_t bx = bx1; bx <= bx2; bx++) {
+			uint8_t bits = (from_flash ? pgm_read_byte(src + bx) : src[bx]) & b_mask;
+
+			if (dst_lo && SSD1306_blit_byte(dst_lo + bx - bx1, bits << shift, mask_lo, mode)) {
+				if (lo_x1 == 0xFF) lo_x1 = bx;
+				lo_x2 = bx;
+			}
+
+			if (dst_hi && SSD1306_blit_byte(dst_hi + bx - bx1, bits >> (8 - shift), mask_hi, mode)) {
+				if (hi_x1 == 0xFF) hi_x1 = bx;
+				hi_x2 = bx;
+			}
 		}
+
+		if (lo_x1 != 0xFF) SSD1306_mark_dirty(page, x + lo_x1, x + lo_x2);
+		if (hi_x1 != 0xFF) SSD1306_mark_dirty(page + 1, x + hi_x1, x + hi_x2);
 	}
 }
 
 // draws the text using specified bmp resolver
-void SSD1306_graphics_text(
+static void SSD1306_raster_text(
 	const char *str,
 	uint16_t x,
 	uint16_t y,
@@ -238,9 +603,477 @@ void SSD1306_graphics_text(
 		uint8_t* bmp = (*resolver)(str[i], &w, &h);
 
 		// draw the symbol
-		SSD1306_graphics_bitmap(bmp, w, h, x, y);
+		if (x < __SSD1306_WIDTH && y < __SSD1306_HEIGHT)
+			SSD1306_raster_bitmap(bmp, w, h, x, y, SSD1306_BLIT_COPY, 1);
 
 		// move the cursor
 		x += w + 1;
 	}
-}
\ No newline at end of file
+}
+
+
+#ifdef SSD1306_PAGE_STREAMING
+
+// the length of operation in the display list, with the operation byte
+static uint16_t SSD1306_op_length(const uint8_t *op) {
+	switch (op[0]) {
+		case SSD1306_OP_FILL:
+		case SSD1306_OP_RECTANGLE:
+			return 1 + 5;
+
+		case SSD1306_OP_BITMAP:
+			return 1 + 5 + sizeof(const uint8_t *);
+
+		default:
+			return 1 + 2 + sizeof(SSD1306_resolver) + strlen((const char *)op + 1 + 2 + sizeof(SSD1306_resolver)) + 1;
+	}
+}
+
+// append the operation with length bytes of arguments to the display list
+// returns the arguments, 0 if the list is full (the operation is dropped)
+static uint8_t *SSD1306_record(uint8_t op, uint16_t length) {
+	if (SSD1306_display_list_length + 1 + length > SSD1306_DISPLAY_LIST_SIZE) {
+		SSD1306_display_list_overflows++;
+		return 0;
+	}
+
+	uint8_t *bytes = SSD1306_display_list + SSD1306_display_list_length;
+	bytes[0] = op;
+
+	SSD1306_display_list_length += 1 + length;
+	if (SSD1306_display_list_length > SSD1306_display_list_peak)
+		SSD1306_display_list_peak = SSD1306_display_list_length;
+
+	return bytes + 1;
+}
+
+// record the operation with the corners of area and the color
+static void SSD1306_record_area(uint8_t op, uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, int color) {
+	uint8_t *args = SSD1306_record(op, 5);
+	if (!args) return;
+
+	args[0] = x1;
+	args[1] = y1;
+	args[2] = x2;
+	args[3] = y2;
+	args[4] = color;
+}
+
+static void SSD1306_fill_area(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, int color) {
+	SSD1306_record_area(SSD1306_OP_FILL, x1, y1, x2, y2, color);
+}
+
+static void SSD1306_rectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, int color) {
+	SSD1306_record_area(SSD1306_OP_RECTANGLE, x1, y1, x2, y2, color);
+}
+
+static void SSD1306_draw_bitmap(
+	const uint8_t *bmp,
+	uint8_t w,
+	uint8_t h,
+	uint8_t x,
+	uint8_t y,
+	uint8_t mode,
+	uint8_t from_flash)
+{
+	// out of bounds
+	if (x >= __SSD1306_WIDTH || y >= __SSD1306_HEIGHT) return;
+
+	uint8_t *args = SSD1306_record(SSD1306_OP_BITMAP, 5 + sizeof(bmp));
+	if (!args) return;
+
+	args[0] = x;
+	args[1] = y;
+	args[2] = w;
+	args[3] = h;
+	args[4] = mode | (from_flash ? SSD1306_OP_FLASH : 0);
+	memcpy(args + 5, &bmp, sizeof(bmp));
+}
+
+static void SSD1306_text(
+	const char *str,
+	uint16_t x,
+	uint16_t y,
+	uint8_t*(*resolver)(char, uint16_t*, uint16_t*)) {
+
+	// out of bounds, the next lines begin at the same x and lower
+	if (x >= __SSD1306_WIDTH || y >= __SSD1306_HEIGHT) return;
+
+	// the text is copied, the string may be gone before the render
+	uint16_t length = strlen(str) + 1;
+
+	uint8_t *args = SSD1306_record(SSD1306_OP_TEXT, 2 + sizeof(resolver) + length);
+	if (!args) return;
+
+	args[0] = x;
+	args[1] = y;
+	memcpy(args + 2, &resolver, sizeof(resolver));
+	memcpy(args + 2 + sizeof(resolver), str, length);
+}
+
+// rasterize the display list into the strip of columns x..x + SSD1306_STRIP_WIDTH - 1 of the page
+static void SSD1306_rasterize(uint8_t page, uint8_t x) {
+	SSD1306_strip_page = page;
+	SSD1306_strip_x = x;
+
+	memset(SSD1306_strip, SSD1306_background ? 0xFF : 0x00, SSD1306_STRIP_WIDTH);
+	SSD1306_COUNT_BYTES(SSD1306_STRIP_WIDTH);
+
+	uint16_t i = 0;
+
+	while (i < SSD1306_display_list_length) {
+		uint8_t op = SSD1306_display_list[i];
+		const uint8_t *args = SSD1306_display_list + i + 1;
+
+		switch (op) {
+			case SSD1306_OP_FILL:
+				SSD1306_raster_fill_area(args[0], args[1], args[2], args[3], args[4]);
+				break;
+
+			case SSD1306_OP_RECTANGLE:
+				SSD1306_raster_rectangle(args[0], args[1], args[2], args[3], args[4]);
+				break;
+
+			case SSD1306_OP_BITMAP: {
+				const uint8_t *bmp;
+				memcpy(&bmp, args + 5, sizeof(bmp));
+
+				SSD1306_raster_bitmap(
+					bmp,
+					args[2],
+					args[3],
+					args[0],
+					args[1],
+					args[4] & ~SSD1306_OP_FLASH,
+					args[4] & SSD1306_OP_FLASH);
+				break;
+			}
+
+			default: {
+				SSD1306_resolver resolver;
+				memcpy(&resolver, args + 2, sizeof(resolver));
+
+				SSD1306_raster_text((const char *)args + 2 + sizeof(resolver), args[0], args[1], resolver);
+				break;
+			}
+		}
+
+		i += SSD1306_op_length(SSD1306_display_list + i);
+	}
+}
+
+// 1 if the operation may draw to the strip of columns x..x + SSD1306_STRIP_WIDTH - 1 of the page
+static uint8_t SSD1306_op_touches(const uint8_t *op, uint8_t page, uint8_t x) {
+	const uint8_t *args = op + 1;
+
+	// the box the operation may draw to, inclusive
+	uint16_t x1, y1, x2, y2;
+
+	switch (op[0]) {
+		case SSD1306_OP_FILL:
+		case SSD1306_OP_RECTANGLE:
+			x1 = args[0] < args[2] ? args[0] : args[2];
+			x2 = args[0] < args[2] ? args[2] : args[0];
+			y1 = args[1] < args[3] ? args[1] : args[3];
+			y2 = args[1] < args[3] ? args[3] : args[1];
+			break;
+
+		case SSD1306_OP_BITMAP:
+			if (!args[2] || !args[3]) return 0;
+
+			x1 = args[0];
+			y1 = args[1];
+			x2 = x1 + args[2] - 1;
+			y2 = y1 + args[3] - 1;
+			break;
+
+		default: {
+			// the symbols are placed like SSD1306_raster_text() does it
+			SSD1306_resolver resolver;
+			memcpy(&resolver, args + 2, sizeof(resolver));
+
+			const char *str = (const char *)args + 2 + sizeof(resolver);
+
+			x1 = x2 = args[0];
+			y1 = y2 = args[1];
+
+			uint16_t symbol_x = x1, symbol_y = y1;
+
+			for (uint8_t i = 0; str[i]; i++) {
+				if (str[i] == '\n') {
+					symbol_y += 9;
+					symbol_x = x1;
+					continue;
+				}
+
+				uint16_t w, h;
+				(*resolver)(str[i], &w, &h);
+
+				if (w && symbol_x + w - 1 > x2) x2 = symbol_x + w - 1;
+				if (h && symbol_y + h - 1 > y2) y2 = symbol_y + h - 1;
+
+				symbol_x += w + 1;
+			}
+			break;
+		}
+	}
+
+	return x1 <= x + SSD1306_STRIP_WIDTH - 1 && x2 >= x && y1 / 8 <= page && y2 / 8 >= page;
+}
+
+// the hash of the background and the operations that may draw to the strip
+// a strip is drawn only by them, so it is the same if they are the same
+// sets is_volatile to 1 if a bitmap in RAM is among them, it may have changed behind the same pointer
+static uint16_t SSD1306_strip_hash(uint8_t page, uint8_t x, uint8_t *is_volatile) {
+	uint16_t hash = SSD1306_background;
+	uint16_t i = 0;
+
+	while (i < SSD1306_display_list_length) {
+		const uint8_t *op = SSD1306_display_list + i;
+		uint16_t length = SSD1306_op_length(op);
+
+		if (SSD1306_op_touches(op, page, x)) {
+			if (op[0] == SSD1306_OP_BITMAP && !(op[5] & SSD1306_OP_FLASH)) *is_volatile = 1;
+
+			// hash * 33 + byte (djb2)
+			for (uint16_t j = 0; j < length; j++)
+				hash = (hash << 5) + hash + op[j];
+		}
+
+		i += length;
+	}
+
+	return hash;
+}
+
+// called from the I2C interrupt when the strip is sent
+static void SSD1306_strip_sent(void) {
+	SSD1306_strips_sent++;
+}
+
+// the contents of display are unknown, so every strip is sent
+void SSD1306_invalidate(void) {
+	SSD1306_is_invalid = 1;
+}
+
+// send every strip to display
+void SSD1306_render_full(void) {
+	SSD1306_invalidate();
+	SSD1306_render_dirty();
+}
+
+// send the strips whose operations have changed since the last render
+// a hash collision leaves the strip as it was, until it changes again or the full render
+// the strip is rasterized while the previous one is being sent
+void SSD1306_render_dirty(void) {
+	// the previous frame may still be in the queue
+	SSD1306_wait();
+
+	// new frame
+	SSD1306_bytes_sent = 0;
+
+	for (uint8_t page = 0; page < __SSD1306_PAGES; page++) {
+		// 1 if the window of the previous strip goes on to this one
+		uint8_t is_continued = 0;
+
+		for (uint8_t strip = 0; strip < SSD1306_STRIPS; strip++) {
+			uint8_t x = strip * SSD1306_STRIP_WIDTH;
+
+			uint8_t is_volatile = 0;
+			uint16_t hash = SSD1306_strip_hash(page, x, &is_volatile);
+
+			// the display already shows it
+			if (!SSD1306_is_invalid && !is_volatile && hash == SSD1306_strip_hashes[page][strip]) {
+				is_continued = 0;
+				continue;
+			}
+
+			SSD1306_strip_hashes[page][strip] = hash;
+
+			// the other buffer may be being sent, this one must be over
+			SSD1306_strip_buffer ^= 1;
+			while ((uint8_t)(SSD1306_strips_queued - SSD1306_strips_sent) > 1);
+
+			SSD1306_strip = SSD1306_strip_buffers[SSD1306_strip_buffer];
+			SSD1306_rasterize(page, x);
+
+			// the window from this strip to the end of page
+			if (!is_continued) {
+				uint8_t *commands = SSD1306_strip_commands[SSD1306_strip_buffer];
+				uint8_t length = SSD1306_window_commands(
+					commands,
+					x,
+					__SSD1306_WIDTH - 1,
+					page,
+					page);
+				SSD1306_queue(commands, length, 0, 0, 0);
+				is_continued = 1;
+			}
+
+			// counted before, the host sends it at once
+			SSD1306_strips_queued++;
+			SSD1306_queue_data(SSD1306_strip, SSD1306_STRIP_WIDTH, SSD1306_strip_sent);
+		}
+	}
+
+	// the display is up to date
+	SSD1306_is_invalid = 0;
+}
+
+#else
+
+// without the display list the drawing goes to the framebuffer at once
+#define SSD1306_fill_area SSD1306_raster_fill_area
+#define SSD1306_rectangle SSD1306_raster_rectangle
+#define SSD1306_draw_bitmap SSD1306_raster_bitmap
+#define SSD1306_text SSD1306_raster_text
+
+#endif
+
+
+// fill the screen
+void SSD1306_graphics_fill(int color) {
+#ifdef SSD1306_PAGE_STREAMING
+	// the fill covers everything drawn before, a new display list begins
+	SSD1306_display_list_length = 0;
+	SSD1306_background = color;
+#else
+	// a new frame begins, the previous one must be sent
+	SSD1306_wait();
+
+	SSD1306_fill_area(0, 0, __SSD1306_WIDTH - 1, __SSD1306_HEIGHT - 1, color);
+#endif
+}
+
+// set the pixel
+void SSD1306_graphics_set(uint8_t x, uint8_t y, int color) {
+	SSD1306_fill_area(x, y, x, y, color);
+}
+
+// draws the horizontal line
+void SSD1306_graphics_hline(uint8_t x1, uint8_t x2, uint8_t y, int color) {
+	SSD1306_fill_area(x1, y, x2, y, color);
+}
+
+// draws the vertical line
+void SSD1306_graphics_vline(uint8_t y1, uint8_t y2, uint8_t x, int color) {
+	SSD1306_fill_area(x, y1, x, y2, color);
+}
+
+// draws the rectangle
+void SSD1306_graphics_rectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, int color) {
+	SSD1306_rectangle(x1, y1, x2, y2, color);
+}
+
+// draws the filled rectangle
+void SSD1306_graphics_filled_rectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, int color) {
+	SSD1306_fill_area(x1, y1, x2, y2, color);
+}
+
+// draws the bitmap
+void SSD1306_graphics_bitmap(const uint8_t *bmp, uint8_t w, uint8_t h, uint8_t x, uint8_t y) {
+	SSD1306_draw_bitmap(bmp, w, h, x, y, SSD1306_BLIT_COPY, 0);
+}
+
+// draws the bitmap stored in flash
+void SSD1306_graphics_bitmap_P(const uint8_t *bmp, uint8_t w, uint8_t h, uint8_t x, uint8_t y) {
+	SSD1306_draw_bitmap(bmp, w, h, x, y, SSD1306_BLIT_COPY, 1);
+}
+
+// draws the bitmap using the blit mode
+void SSD1306_graphics_blit(const uint8_t *bmp, uint8_t w, uint8_t h, uint8_t x, uint8_t y, uint8_t mode) {
+	SSD1306_draw_bitmap(bmp, w, h, x, y, mode, 0);
+}
+
+// draws the bitmap stored in flash using the blit mode
+void SSD1306_graphics_blit_P(const uint8_t *bmp, uint8_t w, uint8_t h, uint8_t x, uint8_t y, uint8_t mode) {
+	SSD1306_draw_bitmap(bmp, w, h, x, y, mode, 1);
+}
+
+// draws the text using specified bmp resolver
+void SSD1306_graphics_text(
+	const char *str,
+	uint16_t x,
+	uint16_t y,
+	uint8_t*(*resolver)(char, uint16_t*, uint16_t*)) {
+
+	SSD1306_text(str, x, y, resolver);
+}
+
+// draws the text aligned relative to the point (x, y)
+// moves the top left corner of w x h box, so the box is aligned relative to (x, y)
+static void SSD1306_align(uint8_t *x, uint8_t *y, uint16_t w, uint16_t h, uint8_t align) {
+	int16_t box_x = *x;
+	int16_t box_y = *y;
+
+	if (align & SSD1306_ALIGN_HCENTER) box_x -= w / 2;
+	else if (align & SSD1306_ALIGN_RIGHT) box_x -= w;
+
+	if (align & SSD1306_ALIGN_VCENTER) box_y -= h / 2;
+	else if (align & SSD1306_ALIGN_BOTTOM) box_y -= h;
+
+	// the box doesn't fit, keep its beginning on screen
+	if (box_x < 0) box_x = 0;
+	if (box_y < 0) box_y = 0;
+
+	*x = box_x;
+	*y = box_y;
+}
+
+void SSD1306_graphics_text_aligned(
+	const char *str,
+	uint8_t x,
+	uint8_t y,
+	uint8_t align,
+	uint8_t*(*resolver)(char, uint16_t*, uint16_t*),
+	uint8_t (*width)(char)) {
+
+	// measure the text, only the widths of symbols are needed
+	uint16_t text_w = 0;
+	uint16_t text_h = 0;
+	uint16_t line_w = 0;
+	uint16_t line_y = 0;
+
+	for (int i = 0; str[i]; ++i) {
+		// check if newline
+		if (str[i] == '\n') {
+			line_y += 9;
+			line_w = 0;
+			continue;
+		}
+
+		line_w += (*width)(str[i]) + 1;
+
+		if (line_w > text_w) text_w = line_w;
+		text_h = line_y + 8;
+	}
+
+	// move the text relative to the point
+	SSD1306_align(&x, &y, text_w, text_h, align);
+
+	SSD1306_graphics_text(str, x, y, resolver);
+}
+
+// measures the single line of text
+uint16_t SSD1306_text_width(const char *str, uint8_t (*width)(char)) {
+	uint16_t text_w = 0;
+
+	for (int i = 0; str[i]; ++i)
+		text_w += (*width)(str[i]) + 1;
+
+	return text_w;
+}
+
+// draws the pre-rasterized label stored in flash aligned relative to the point (x, y)
+void SSD1306_graphics_label_aligned(
+	const uint8_t *bmp,
+	uint8_t w,
+	uint8_t h,
+	uint8_t x,
+	uint8_t y,
+	uint8_t align) {
+
+	SSD1306_align(&x, &y, w, h, align);
+
+	SSD1306_draw_bitmap(bmp, w, h, x, y, SSD1306_BLIT_COPY, 1);
+}
@@ -9,11 +9,70 @@
 // resolution of the display
 #define __SSD1306_WIDTH 	128
 #define __SSD1306_HEIGHT 	32
+// amount of 8-pixel pages
+#define __SSD1306_PAGES 	(__SSD1306_HEIGHT / 8)
 
 // colors
 #define SSD1306_WHITE 1
 #define SSD1306_BLACK 0
 
+// render modes
+// send the whole framebuffer
+#define SSD1306_RENDER_FULL 0
+// send only the columns changed since the last render
+#define SSD1306_RENDER_DIRTY 1
+
+// bitmap drawing modes
+// the bitmap replaces the pixels
+#define SSD1306_BLIT_COPY 0
+// only the set pixels of bitmap are drawn
+#define SSD1306_BLIT_OR 1
+// the set pixels of bitmap invert the pixels
+#define SSD1306_BLIT_XOR 2
+
+// text alignment relative to the anchor point, horizontal and vertical flags are combined
+#define SSD1306_ALIGN_LEFT		0x00
+#define SSD1306_ALIGN_HCENTER	0x01
+#define SSD1306_ALIGN_RIGHT		0x02
+#define SSD1306_ALIGN_TOP		0x00
+#define SSD1306_ALIGN_VCENTER	0x04
+#define SSD1306_ALIGN_BOTTOM	0x08
+
+// the maximum amount of data bytes sent in one I2C transaction
+// 0 - send all data of the window in one transaction
+#ifndef SSD1306_STREAM_CHUNK
+#define SSD1306_STREAM_CHUNK 0
+#endif
+
+// the framebuffer mode marks the columns the drawing has changed, a span per page
+// a frame drawn from scratch marks every drawn column, even if it is the same as on the display;
+// define SSD1306_SHADOW to keep a copy of the display (one more framebuffer of RAM)
+// and send only the columns that differ from it
+
+// the render without framebuffer, define SSD1306_PAGE_STREAMING to use it
+// the drawing functions record the frame as a display list, the render rasterizes it
+// one strip of SSD1306_STRIP_WIDTH columns at a time and sends the strips that have changed
+// a strip has changed if the 16-bit hash of the operations drawing to it differs from
+// the one of the last render (2 bytes of RAM per strip); the bitmaps in RAM are always sent,
+// the text is copied
+// the bitmaps in RAM must live until the render
+#ifdef SSD1306_PAGE_STREAMING
+
+// the size of display list in bytes, the operations that don't fit are dropped
+// a fill, a line or a rectangle takes 6 bytes, a bitmap takes 6 bytes and a pointer,
+// a text takes 3 bytes, a pointer and its characters with 0
+// the busiest screen of MOHG (the monitor) has 11 pointers, so the size depends on them
+#ifndef SSD1306_DISPLAY_LIST_SIZE
+#define SSD1306_DISPLAY_LIST_SIZE ((uint16_t)(144 + 16 * sizeof(void *)))
+#endif
+
+// the width of strip in columns, it divides the width of display
+#ifndef SSD1306_STRIP_WIDTH
+#define SSD1306_STRIP_WIDTH 32
+#endif
+
+#endif
+
 // commands
 #define __SSD1306_CMD__Display_On							0xAF
 #define __SSD1306_CMD__Display_Off							0xAE
@@ -47,6 +106,28 @@
 #define __SSD1306_CMD__Charge_Pump_Set						0x8D
 
 
+/*
+ * VARIABLES
+ */
+
+// the amount of bytes sent over I2C by the last render
+extern uint16_t SSD1306_bytes_sent;
+
+#ifdef SSD1306_KERNEL_COUNTERS
+// the bytes of framebuffer or strip the drawing kernels have visited, the cost of drawing
+// that doesn't depend on the host, the caller resets it
+extern uint32_t SSD1306_kernel_bytes;
+#endif
+
+#ifdef SSD1306_PAGE_STREAMING
+// the bytes of display list used by the frame and the most of them used so far
+extern uint16_t SSD1306_display_list_length;
+extern uint16_t SSD1306_display_list_peak;
+// the amount of operations dropped because the display list was full
+extern uint16_t SSD1306_display_list_overflows;
+#endif
+
+
 /*
  * FUNCTIONS
  */
@@ -58,15 +139,35 @@ void SSD1306_setup(void);
 // if issue_start is 1 then the START and STOP conditions will be sent
 void SSD1306_send_command(uint8_t command, int issue_start);
 
-// send framebuffer to display
+// set the render mode (SSD1306_RENDER_FULL or SSD1306_RENDER_DIRTY)
+void SSD1306_set_render_mode(uint8_t mode);
+
+// mark the whole framebuffer as dirty, the next render sends all of it
+void SSD1306_invalidate(void);
+
+// send framebuffer to display using the active render mode
 void SSD1306_render(void);
 
+// send the whole framebuffer to display
+void SSD1306_render_full(void);
+
+// send only the dirty parts of framebuffer to display
+void SSD1306_render_dirty(void);
+
+// check if the last render is still being sent
+// the framebuffer must not be changed until it is over
+uint8_t SSD1306_is_busy(void);
+
+// wait until the last render is sent
+void SSD1306_wait(void);
+
 
 /*
  * GRAPHICS FUNCTIONS
  */
 
 // fill the screen
+// waits for the last render, so it should begin every frame
 void SSD1306_graphics_fill(int color);
 
 // set the pixel
@@ -87,11 +188,44 @@ void SSD1306_graphics_filled_rectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8
 // draws the bitmap
 void SSD1306_graphics_bitmap(const uint8_t *bmp, uint8_t w, uint8_t h, uint8_t x, uint8_t y);
 
+// draws the bitmap stored in flash
+void SSD1306_graphics_bitmap_P(const uint8_t *bmp, uint8_t w, uint8_t h, uint8_t x, uint8_t y);
+
+// draws the bitmap using the blit mode (SSD1306_BLIT_COPY, SSD1306_BLIT_OR or SSD1306_BLIT_XOR)
+void SSD1306_graphics_blit(const uint8_t *bmp, uint8_t w, uint8_t h, uint8_t x, uint8_t y, uint8_t mode);
+
+// draws the bitmap stored in flash using the blit mode
+void SSD1306_graphics_blit_P(const uint8_t *bmp, uint8_t w, uint8_t h, uint8_t x, uint8_t y, uint8_t mode);
+
 // draws text using specified symbol resolver
+// the resolver returns the bitmaps stored in flash
 void SSD1306_graphics_text(
     const char *str,
     uint16_t x,
     uint16_t y,
     uint8_t*(*resolver)(char, uint16_t*, uint16_t*));
 
+// draws text aligned relative to the point (x, y)
+// the text is measured by the widths of symbols, the resolver is called once per symbol
+// all symbols are 8 pixels tall
+void SSD1306_graphics_text_aligned(
+    const char *str,
+    uint8_t x,
+    uint8_t y,
+    uint8_t align,
+    uint8_t*(*resolver)(char, uint16_t*, uint16_t*),
+    uint8_t (*width)(char));
+
+// measures the single line of text by the widths of symbols
+uint16_t SSD1306_text_width(const char *str, uint8_t (*width)(char));
+
+// draws the pre-rasterized label (see tools/gen_labels.c) aligned relative to the point (x, y)
+void SSD1306_graphics_label_aligned(
+    const uint8_t *bmp,
+    uint8_t w,
+    uint8_t h,
+    uint8_t x,
+    uint8_t y,
+    uint8_t align);
+
 #endif
\ No newline at end of file
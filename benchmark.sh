@@ -0,0 +1,40 @@
+# Measures the cycles of firmware hot paths under simavr (see profile.h).
+# The firmware is built with the flags of compile.sh, plus MOHG_PROFILE.
+# Prints CSV: section,count,min,max,average (cycles, i2c_bytes_per_frame in bytes,
+# sleep_permille in 1/1000 of second spent sleeping).
+# Usage: ./benchmark.sh [simulated seconds, 20 by default]
+# The extra flags are taken from CFLAGS, e.g. CFLAGS=-DMOHG_THERMISTOR_FLOAT to measure the float path.
+
+SECONDS_TO_RUN=${1:-20}
+
+if ! command -v simavr > /dev/null; then
+    echo "simavr is not found" >&2
+    exit 1
+fi
+
+echo "Generating thermistor table..." >&2
+gcc -I tools/host tools/gen_thermistor_table.c utils.c -lm -o gen_thermistor_table
+./gen_thermistor_table > thermistor_table.h
+rm gen_thermistor_table
+
+echo "Rasterizing labels..." >&2
+gcc -I tools/host -fexec-charset=CP866 tools/gen_labels.c -o gen_labels
+./gen_labels > labels.h
+rm gen_labels
+
+echo "Compiling the program..." >&2
+avr-gcc -Wall -Wextra -Os -DF_CPU=8000000UL -DMOHG_PROFILE -mmcu=atmega32 -fexec-charset=CP866 -ffunction-sections -Wl,--gc-sections $CFLAGS -lgcc *.c I2C/*.c SSD1306/*.c -o benchmark.elf || exit 1
+
+echo "Running for $SECONDS_TO_RUN simulated seconds..." >&2
+# the reports are printed every 5 seconds, the last complete one is taken
+# the sections without samples are left out, so the reports are split by their end lines
+echo "section,count,min,max,average"
+timeout $((SECONDS_TO_RUN * 10)) simavr -m atmega32 -f 8000000 benchmark.elf 2>&1 \
+    | tr -d '\r' \
+    | grep -oE 'profile(,|_end).*' \
+    | awk -v last=$((SECONDS_TO_RUN / 5)) '
+        /^profile,/ { report = report substr($0, 9) "\n" }
+        /^profile_end/ { complete = report; report = ""; if (++reports == last) exit }
+        END { printf "%s", complete }'
+
+rm benchmark.elf
@@ -0,0 +1,66 @@
+# Measures the cycles of every UI screen under simavr (see tools/scene_cycles.c).
+# The firmware is built with the flags of compile.sh, plus MOHG_PROFILE.
+# Prints CSV: name,cycles and compares them with the checked-in baseline
+# (tools/scenes/cycles.csv, cycles_streaming.csv for CFLAGS=-DSSD1306_PAGE_STREAMING).
+# The exit code is 1 if a scene takes more than TOLERANCE percent (10 by default) over its baseline.
+# Without the baseline, it is written, commit it. To update it after an intended change, remove it.
+# The extra flags are taken from CFLAGS.
+
+TOLERANCE=${TOLERANCE:-10}
+
+BASELINE=tools/scenes/cycles.csv
+case "$CFLAGS" in
+    *-DSSD1306_PAGE_STREAMING*)
+        BASELINE=tools/scenes/cycles_streaming.csv
+        ;;
+esac
+
+if ! command -v simavr > /dev/null; then
+    echo "simavr is not found" >&2
+    exit 1
+fi
+
+echo "Generating thermistor table..." >&2
+gcc -I tools/host tools/gen_thermistor_table.c utils.c -lm -o gen_thermistor_table
+./gen_thermistor_table > thermistor_table.h
+rm gen_thermistor_table
+
+echo "Rasterizing labels..." >&2
+gcc -I tools/host -fexec-charset=CP866 tools/gen_labels.c -o gen_labels
+./gen_labels > labels.h
+rm gen_labels
+
+echo "Compiling the scenes..." >&2
+# main.c is included by scene_cycles.c
+avr-gcc -Wall -Wextra -Os -DF_CPU=8000000UL -DMOHG_PROFILE -mmcu=atmega32 -fexec-charset=CP866 -ffunction-sections -Wl,--gc-sections $CFLAGS -lgcc tools/scene_cycles.c $(ls *.c | grep -vx main.c) I2C/*.c SSD1306/*.c -o scene_cycles.elf || exit 1
+
+echo "Running the scenes..." >&2
+RESULT=$(timeout 120 simavr -m atmega32 -f 8000000 scene_cycles.elf 2>&1 \
+    | tr -d '\r' \
+    | grep -oE 'scene(,|s_end).*' \
+    | sed -n '/^scenes_end/q; s/^scene,//p')
+
+rm scene_cycles.elf
+
+if [ -z "$RESULT" ]; then
+    echo "No scenes were measured" >&2
+    exit 1
+fi
+
+echo "name,cycles"
+echo "$RESULT"
+
+if [ ! -f "$BASELINE" ]; then
+    { echo "name,cycles"; echo "$RESULT"; } > "$BASELINE"
+    echo "The baseline is written to $BASELINE, commit it." >&2
+    exit 0
+fi
+
+echo "$RESULT" | awk -F, -v tolerance=$TOLERANCE -v baseline="$BASELINE" '
+    BEGIN { while ((getline line < baseline) > 0) { split(line, f, ","); cycles[f[1]] = f[2] } }
+    !($1 in cycles) { print $1 " has no baseline in " baseline > "/dev/stderr"; failed = 1; next }
+    $2 * 100 > cycles[$1] * (100 + tolerance) {
+        printf "%s takes %d cycles, more than %d%% over %d\n", $1, $2, tolerance, cycles[$1] > "/dev/stderr"
+        failed = 1
+    }
+    END { exit failed }'
@@ -1,5 +1,44 @@
+echo "Generating thermistor table..."
+gcc -I tools/host tools/gen_thermistor_table.c utils.c -lm -o gen_thermistor_table
+./gen_thermistor_table > thermistor_table.h
+rm gen_thermistor_table
+
+echo "Rasterizing labels..."
+gcc -I tools/host -fexec-charset=CP866 tools/gen_labels.c -o gen_labels
+./gen_labels > labels.h
+rm gen_labels
+
+# the extra flags are taken from CFLAGS, e.g. CFLAGS=-DMOHG_THERMISTOR_FLOAT for the float reference path
 echo "Compiling the program..."
-avr-gcc -w -Os -DF_CPU=8000000UL -mmcu=atmega32 -fexec-charset=CP866 -lgcc *.c I2C/*.c SSD1306/*.c -o main
+avr-gcc -Wall -Wextra -Os -DF_CPU=8000000UL -mmcu=atmega32 -fexec-charset=CP866 -ffunction-sections -Wl,--gc-sections $CFLAGS -lgcc *.c I2C/*.c SSD1306/*.c -o main
+
+echo "Checking the link map..."
+# the frames are composed without the heap
+if avr-nm main | grep -qwE "malloc|free"; then
+    echo "Error: malloc/free are linked into the firmware!"
+    rm main
+    exit 1
+fi
+
+# the firmware is float-free, only the float reference path pulls the soft-float library in
+FLOAT_SYMBOLS=$(avr-nm main | grep -owE "__(add|sub|mul|div|cmp)sf[23]|__(fix|fixuns)sfsi|__float(un)?sisf|log|exp" | sort -u | tr '\n' ' ')
+if [ -z "$FLOAT_SYMBOLS" ]; then
+    echo "No float math is linked."
+else
+    case "$CFLAGS" in
+        *-DMOHG_THERMISTOR_FLOAT*)
+            echo "Float math is linked by the float reference path: $FLOAT_SYMBOLS"
+            ;;
+        *)
+            echo "Error: float math is linked into the firmware: $FLOAT_SYMBOLS"
+            rm main
+            exit 1
+            ;;
+    esac
+fi
+
+echo "Memory usage:"
+avr-size -C --mcu=atmega32 main
 
 echo "Generating .hex file..."
 avr-objcopy -O ihex -R .eeprom main main.hex
@@ -0,0 +1,26 @@
+# Builds the firmware as a Linux program with the simulated glove (see HAL/host/host.h).
+# The extra flags are taken from CFLAGS, e.g. CFLAGS="-O1 -g -fsanitize=address,undefined"
+
+echo "Generating thermistor table..."
+gcc -I tools/host tools/gen_thermistor_table.c utils.c -lm -o gen_thermistor_table
+./gen_thermistor_table > thermistor_table.h
+rm gen_thermistor_table
+
+echo "Rasterizing labels..."
+gcc -I tools/host -fexec-charset=CP866 tools/gen_labels.c -o gen_labels
+./gen_labels > labels.h
+rm gen_labels
+
+echo "Compiling the program..."
+gcc -Wall -Wextra ${CFLAGS:--O2 -g} -DMOHG_HOST -DF_CPU=8000000UL -fexec-charset=CP866 -I tools/host \
+    main.c scheduler.c thermistor.c filter.c format.c pid.c pwm.c utils.c SSD1306/*.c HAL/host/*.c -lm -o mohg_host
+
+echo "Compiling the scene renderer..."
+gcc -Wall -Wextra ${CFLAGS:--O2 -g} -DMOHG_HOST -DF_CPU=8000000UL -DSSD1306_KERNEL_COUNTERS -fexec-charset=CP866 -I tools/host \
+    tools/render_scenes.c scheduler.c thermistor.c filter.c format.c pid.c pwm.c utils.c SSD1306/*.c HAL/host/*.c -lm -o render_scenes
+
+echo "Compiling the filter benchmark..."
+gcc -Wall -Wextra ${CFLAGS:--O2 -g} -DMOHG_HOST -DF_CPU=8000000UL -I tools/host \
+    tools/bench_filter.c thermistor.c filter.c -lm -o bench_filter
+
+echo "Programs are in files 'mohg_host', 'render_scenes' and 'bench_filter'!"
@@ -12,25 +12,36 @@
 #define BUTTON_MIDDLE_ID 1
 #define BUTTON_RIGHT_ID 2
 
-// aliases for I/O registers
-#define DDR_BUTTONS DDRD
-#define PORT_BUTTONS PORTD
-#define PIN_BUTTONS PIND
+// the I/O port of buttons (its letter, see HAL/HAL.h)
+#define PORT_BUTTONS D
 // pins of buttons
 #define BUTTON_LEFT_PIN PD4
 #define BUTTON_MIDDLE_PIN PD5
 #define BUTTON_RIGHT_PIN PD6
 
 // OUTPUT PINS
-#define DDR_OUTPUT_DEVICES DDRB
-#define PORT_OUTPUT_DEVICES PORTB
-#define PIN_OUTPUT_DEVICES PINB
+// the I/O port of output devices (its letter, see HAL/HAL.h)
+#define PORT_OUTPUT_DEVICES B
 
 #define OUTPUT_DEVICE_THERMISTORS_SWITCH PB0
 
 
-// time interval between temperature measurements
+// time interval between temperature measurements (of each finger)
+// the heater of finger is off for the settle time and its conversions: 17 of them take
+// about 1.9 ms at 125 kHz, see ADC.h; the sweep mode turns all heaters off for
+// about 10 ms of every interval, it costs 5% of the heating power
 #define MOHG_MEASURE_INTERVAL 0.2
+// the modes of measurement:
+// all heaters are turned off and all thermistors are measured at once
+#define MOHG_MEASURE_SWEEP 0
+// one thermistor is measured at a time and only its heater is turned off,
+// the fingers take turns, so MOHG_MEASURE_INTERVAL is split between them
+#define MOHG_MEASURE_INTERLEAVED 1
+// the mode of measurement
+#define MOHG_MEASURE_MODE MOHG_MEASURE_INTERLEAVED
+// the time heaters are off and thermistors are supplied before the conversion (in seconds)
+// it is counted in timer ticks: the delay is at least this and less than one tick longer
+#define MOHG_MEASURE_SETTLE 0.001
 // time interval between display update and render
 #define MOHG_DISPLAY_INTERVAL 0.25
 
@@ -43,6 +54,27 @@
 // the resistance of constant resistor in voltage-divider circuit
 #define MOHG_THERMISTOR_DIVIDER_R 100000.0
 
+// FILTERING OF THERMISTOR SAMPLES (see filter.h)
+// the extra bits of oversampling, every sample is the sum of 4^bits conversions (0 to 3)
+#define MOHG_FILTER_OVERSAMPLE_BITS 2
+// 1 to take the median of the last 3 samples, it removes single spikes
+#define MOHG_FILTER_MEDIAN 1
+// the IIR low-pass moves by 1/2^shift of the difference every sample (0 disables it)
+#define MOHG_FILTER_IIR_SHIFT 2
+
+// HEATING CONTROL
+// the amount of timer ticks in one period of heater PWM (up to 255)
+#define MOHG_PWM_STEPS 100
+// the maximum amount of heaters that are on at once, limits the peak current
+#define MOHG_PWM_MAX_ACTIVE 3
+// the gains of PID controllers, the output is the duty (in PWM steps):
+// per degree Celsius of error
+#define MOHG_PID_KP 40.0
+// per degree Celsius of error integrated over one second
+#define MOHG_PID_KI 2.0
+// per degree Celsius per second of temperature change
+#define MOHG_PID_KD 20.0
+
 // the gap between upper and lower threshold of temperature values
 #define TEMPERATURE_GAP 2
 // the minimum temperature that is possible to be set.
@@ -0,0 +1,82 @@
+#include "filter.h"
+
+#include "thermistor.h"
+#include "configuration.h"
+
+
+/*
+ * Fill the state with the value, so the filter starts from it.
+ */
+void f_filter_start(filter_state *filter, uint16_t value) {
+    filter->history[0] = value;
+    filter->history[1] = value;
+    filter->history[2] = value;
+    filter->head = 0;
+    filter->value = value;
+    filter->is_started = 1;
+}
+
+/*
+ * Decimate the sum of FILTER_OVERSAMPLE conversions to the fine ADC value.
+ */
+uint16_t f_filter_decimate(uint16_t sum) {
+    // the sum has twice as many extra bits as there are effective ones
+    return (sum >> MOHG_FILTER_OVERSAMPLE_BITS)
+        << (THERMISTOR_FINE_BITS - MOHG_FILTER_OVERSAMPLE_BITS);
+}
+
+/*
+ * Put the value to the ring buffer, returns the median of the last 3 values.
+ */
+uint16_t f_filter_median(filter_state *filter, uint16_t value) {
+    filter->history[filter->head] = value;
+    if (++filter->head == 3) filter->head = 0;
+
+    uint16_t a = filter->history[0];
+    uint16_t b = filter->history[1];
+    uint16_t c = filter->history[2];
+
+    // max(min(a, b), min(max(a, b), c))
+    if (a > b) {
+        uint16_t t = a;
+        a = b;
+        b = t;
+    }
+    if (b > c) b = c;
+
+    return a > b ? a : b;
+}
+
+/*
+ * One step of IIR low-pass, returns its output.
+ */
+uint16_t f_filter_iir(filter_state *filter, uint16_t value) {
+    uint16_t y = filter->value;
+
+    // the difference is taken unsigned, so it doesn't overflow
+    if (value > y) y += (value - y) >> MOHG_FILTER_IIR_SHIFT;
+    else y -= (y - value) >> MOHG_FILTER_IIR_SHIFT;
+
+    filter->value = y;
+    return y;
+}
+
+/*
+ * Pass the sum of FILTER_OVERSAMPLE conversions through all stages.
+ * Returns the fine ADC value.
+ */
+uint16_t f_filter_update(filter_state *filter, uint16_t sum) {
+    uint16_t value = f_filter_decimate(sum);
+
+    if (!filter->is_started) f_filter_start(filter, value);
+
+#if MOHG_FILTER_MEDIAN
+    value = f_filter_median(filter, value);
+#endif
+
+#if MOHG_FILTER_IIR_SHIFT
+    value = f_filter_iir(filter, value);
+#endif
+
+    return value;
+}
@@ -0,0 +1,56 @@
+#ifndef MOHG__FILTER_H
+#define MOHG__FILTER_H
+
+#include <stdint.h>
+
+/*
+    Integer filtering of thermistor samples, every channel has its own state.
+    The stages (see configuration.h):
+    1. the ADC sweep sums FILTER_OVERSAMPLE conversions of channel, the sum is
+       decimated to MOHG_FILTER_OVERSAMPLE_BITS extra bits;
+    2. the median of the last 3 values removes single spikes (MOHG_FILTER_MEDIAN);
+    3. the IIR low-pass smooths the rest (MOHG_FILTER_IIR_SHIFT).
+    The values are ADC values with THERMISTOR_FINE_BITS fraction bits,
+    see f_thermistor_centidegrees_fine().
+*/
+
+// the amount of conversions summed per sample, pass it to f_start_ADC_sweep()
+#define FILTER_OVERSAMPLE (1 << 2 * MOHG_FILTER_OVERSAMPLE_BITS)
+
+typedef struct {
+    // the ring buffer of the last values for the median
+    uint16_t history[3];
+    uint8_t head;
+    // the output of IIR low-pass
+    uint16_t value;
+    // 0 until the first sample
+    uint8_t is_started;
+} filter_state;
+
+/*
+ * Fill the state with the value, so the filter starts from it.
+ */
+void f_filter_start(filter_state *filter, uint16_t value);
+
+/*
+ * Decimate the sum of FILTER_OVERSAMPLE conversions to the fine ADC value.
+ */
+uint16_t f_filter_decimate(uint16_t sum);
+
+/*
+ * Put the value to the ring buffer, returns the median of the last 3 values.
+ */
+uint16_t f_filter_median(filter_state *filter, uint16_t value);
+
+/*
+ * One step of IIR low-pass, returns its output.
+ */
+uint16_t f_filter_iir(filter_state *filter, uint16_t value);
+
+/*
+ * Pass the sum of FILTER_OVERSAMPLE conversions through all stages.
+ * Returns the fine ADC value.
+ */
+uint16_t f_filter_update(filter_state *filter, uint16_t sum);
+
+#endif
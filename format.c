@@ -0,0 +1,88 @@
+#include "format.h"
+
+
+/*
+ * Start the empty text in the buffer.
+ */
+void f_format_init(format_buffer *text, char *buffer, uint8_t size) {
+    text->buffer = buffer;
+    text->size = size;
+    text->length = 0;
+
+    if (size) buffer[0] = 0;
+}
+
+
+/*
+ * Append one character.
+ */
+void f_format_char(format_buffer *text, char c) {
+    // keep the place for zero
+    if (text->length + 1 >= text->size) return;
+
+    text->buffer[text->length++] = c;
+    text->buffer[text->length] = 0;
+}
+
+
+/*
+ * Append the string.
+ */
+void f_format_str(format_buffer *text, const char *str) {
+    while (*str && text->length + 1 < text->size)
+        text->buffer[text->length++] = *str++;
+
+    if (text->size) text->buffer[text->length] = 0;
+}
+
+
+/*
+ * Append the decimal integer.
+ */
+void f_format_int(format_buffer *text, int32_t value) {
+    // the digits in reverse order
+    char digits[10];
+    uint8_t amount = 0;
+
+    uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+
+    // 16-bit division is much cheaper, most of values fit
+    if (magnitude <= UINT16_MAX) {
+        uint16_t short_magnitude = magnitude;
+        do {
+            digits[amount++] = '0' + short_magnitude % 10;
+            short_magnitude /= 10;
+        } while (short_magnitude);
+    } else {
+        do {
+            digits[amount++] = '0' + magnitude % 10;
+            magnitude /= 10;
+        } while (magnitude);
+    }
+
+    if (value < 0) f_format_char(text, '-');
+
+    while (amount) f_format_char(text, digits[--amount]);
+}
+
+
+/*
+ * Append the fixed-point value given in hundredths.
+ */
+void f_format_centi(format_buffer *text, int16_t value, uint8_t decimals) {
+    // the integer part only, truncated towards zero
+    if (decimals == 0) {
+        f_format_int(text, value / 100);
+        return;
+    }
+
+    uint16_t magnitude = value < 0 ? -(int32_t)value : value;
+    uint8_t fraction = magnitude % 100;
+
+    if (value < 0) f_format_char(text, '-');
+    f_format_int(text, magnitude / 100);
+    f_format_char(text, '.');
+
+    f_format_char(text, '0' + fraction / 10);
+    if (decimals >= 2) f_format_char(text, '0' + fraction % 10);
+}
@@ -0,0 +1,42 @@
+#ifndef MOHG__FORMAT_H
+#define MOHG__FORMAT_H
+
+#include <stdint.h>
+
+// the text being appended to the buffer provided by caller
+typedef struct {
+    // the buffer and its size (including the terminating zero)
+    char *buffer;
+    uint8_t size;
+    // the length of text
+    uint8_t length;
+} format_buffer;
+
+/*
+ * Start the empty text in the buffer.
+ * The text is always terminated by zero, the characters that don't fit are dropped.
+ */
+void f_format_init(format_buffer *text, char *buffer, uint8_t size);
+
+/*
+ * Append one character.
+ */
+void f_format_char(format_buffer *text, char c);
+
+/*
+ * Append the string.
+ */
+void f_format_str(format_buffer *text, const char *str);
+
+/*
+ * Append the decimal integer.
+ */
+void f_format_int(format_buffer *text, int32_t value);
+
+/*
+ * Append the fixed-point value given in hundredths (e.g. centidegrees).
+ * decimals - the amount of digits after the point (0, 1 or 2), the rest is truncated.
+ */
+void f_format_centi(format_buffer *text, int16_t value, uint8_t decimals);
+
+#endif
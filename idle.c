@@ -0,0 +1,66 @@
+#include "idle.h"
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#include "timers.h"
+
+// the time spent sleeping (in timer clock periods)
+static uint32_t g_idle_sleep_counts = 0;
+// the time the statistics are collected from (in timer clock periods)
+static uint32_t g_idle_window_start = 0;
+
+
+/*
+ * Sleep until an interrupt, unless the deadline (in timer ticks) has come.
+ */
+void f_idle(uint32_t deadline) {
+    // no interrupts between the check and the sleep
+    cli();
+
+    // the deadline has come while the tasks were running
+    if ((int32_t)(f_timer_get_ticks() - deadline) >= 0) {
+        sei();
+        return;
+    }
+
+    // Idle keeps the timers running. ADC Noise Reduction would stop Timer0 for
+    // the whole sweep (milliseconds), so the tick, the PWM and the scheduler would lose time.
+    set_sleep_mode(SLEEP_MODE_IDLE);
+
+    uint32_t fell_asleep = f_timer_get_counts();
+
+    // the instruction after sei() is executed before any interrupt
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+
+    g_idle_sleep_counts += f_timer_get_counts() - fell_asleep;
+}
+
+
+/*
+ * Returns the part of time spent sleeping (in 1/1000) since the previous call.
+ */
+uint16_t f_idle_get_sleep_permille(void) {
+    uint32_t now = f_timer_get_counts();
+
+    uint32_t total = now - g_idle_window_start;
+    uint32_t asleep = g_idle_sleep_counts;
+
+    // new window
+    g_idle_window_start = now;
+    g_idle_sleep_counts = 0;
+
+    if (total == 0) return 0;
+
+    // keep asleep * 1000 in 32 bits
+    while (total > UINT32_MAX / 1000) {
+        total >>= 1;
+        asleep >>= 1;
+    }
+
+    return asleep * 1000 / total;
+}
@@ -0,0 +1,18 @@
+#ifndef MOHG__IDLE_H
+#define MOHG__IDLE_H
+
+#include <stdint.h>
+
+/*
+ * Sleep until an interrupt, unless the deadline (in timer ticks) has come.
+ * Timer ticks, ADC and I2C interrupts wake the CPU, the buttons are polled on ticks.
+ * Uses Idle mode, the timers keep running.
+ */
+void f_idle(uint32_t deadline);
+
+/*
+ * Returns the part of time spent sleeping (in 1/1000) since the previous call.
+ */
+uint16_t f_idle_get_sleep_permille(void);
+
+#endif
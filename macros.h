@@ -11,7 +11,7 @@
 
 // get pin state
 #define GET_PIN_STATE(PIN, PIN_NUMBER) \
-	(PIN &= 1 << PIN_NUMBER)
+	(PIN & 1 << PIN_NUMBER)
 
 
 #endif
\ No newline at end of file
@@ -3,90 +3,148 @@
     Special for 'Microcontroller Operated Heating Glove' project (MOHG)
 */
 
-#include <stdlib.h>
 #include <string.h>
-#include <math.h>
-
-#include <avr/io.h>
-#include <util/delay.h>
 
+#include "HAL/HAL.h"
 #include "I2C/I2C.h"
 #include "SSD1306/SSD1306.h"
 #include "SSD1306/Bitmaps.h"
+#include "labels.h"
 
 #include "configuration.h"
-#include "macros.h"
 
 #include "ADC.h"
 #include "timers.h"
+#include "scheduler.h"
+#include "idle.h"
+#include "thermistor.h"
+#include "filter.h"
+#include "pid.h"
+#include "pwm.h"
+#include "format.h"
+#include "profile.h"
 #include "utils.h"
 
-// the amount of timer ticks since controller initialization
+// the amount of timer ticks at the beginning of main loop iteration
 uint32_t g_timer_ticks = 0;
-// timer ticks when g_running_for incremented
-uint32_t g_timer_second_counter_tick = 0;
-// timer ticks when we have checked the temperature the last time
-uint32_t g_timer_measure_tick = 0;
-// timer ticks when we have flushed the display data
-uint32_t g_timer_display_tick = 0;
 
 // amount of seconds the device is running for
 uint32_t g_running_for = 0;
+// the part of the last second spent sleeping (in 1/1000)
+uint16_t g_sleep_permille = 0;
 
 // the active user menu
 uint8_t g_active_menu = MENU_MAIN;
 // debug menu page
 uint8_t g_debug_menu_page = DEBUG_MEUN_MONITOR;
 
-// heater states (on/off)
-int g_heater_states[THERMISTOR_AMOUNT];
-// the temperature of the fingers
-double g_finger_temperatures[THERMISTOR_AMOUNT];
+// the controllers of heaters
+pid_state g_heater_controllers[THERMISTOR_AMOUNT];
+// the temperature of the fingers (in centidegrees)
+int16_t g_finger_temperatures[THERMISTOR_AMOUNT];
+// the sums of ADC values of thermistors, filled by the ADC interrupt
+uint16_t g_thermistor_samples[THERMISTOR_AMOUNT];
+// the filters of thermistor samples
+filter_state g_thermistor_filters[THERMISTOR_AMOUNT];
+// the stage of measurement
+#define MEASURE_IDLE 0
+#define MEASURE_SETTLING 1
+#define MEASURE_CONVERTING 2
+uint8_t g_measure_stage = MEASURE_IDLE;
+// the thermistors of measurement in progress
+uint8_t g_measure_first = 0;
+uint8_t g_measure_amount = 0;
+// the tick the conversion starts at, when the heaters and the supply have settled
+uint32_t g_measure_settle_tick = 0;
+#if MOHG_MEASURE_MODE == MOHG_MEASURE_INTERLEAVED
+// the thermistor measured next
+uint8_t g_measure_next = 0;
+#endif
 // is heating active
 int g_is_heating_active = 0;
 // target temperature
 int16_t g_target_temperature = TEMPERATURE_INITIAL;
 
+// the values the screens depend on, the frame is drawn only when they change
+// the values that the active screen doesn't show are 0
+typedef struct {
+    uint8_t menu;
+    uint8_t debug_page;
+    uint8_t is_heating_active;
+    int16_t target;
+    // the displayed temperatures (in whole degrees, as f_format_centi() shows them)
+    int16_t average_temperature;
+    int16_t temperatures[THERMISTOR_AMOUNT];
+    // the lengths of duty bars (in pixels, plus 1), 0 if the bar isn't drawn
+    uint8_t duty_bars[HEATER_AMOUNT];
+    uint8_t achieved_bars[HEATER_AMOUNT];
+} ui_state;
+
+// the state the last frame was drawn for
+ui_state g_ui_drawn;
+// is the last frame still valid
+int g_is_ui_drawn = 0;
+// the amount of display updates that didn't draw because nothing has changed
+uint32_t g_skipped_frames = 0;
+
 // bounce effect cancellation
 uint32_t g_bounce_cancellation_ticks[BUTTON_AMOUNT];
 // button hold
 uint32_t g_button_hold_tick[BUTTON_AMOUNT];
 
 /*
- * This functions measures the temperatures of all finger thermistors.
- * It enables and disables the ADC subsystem by itself.
- * The resulting values are put into g_finger_temperatures variable.
- * Heaters are disabled before meausurement and enabled after it (only if heating is active).
+ * This functions starts measuring the temperatures of amount finger thermistors
+ * beginning with first.
+ * The heaters of these fingers are turned off and the thermistors are supplied,
+ * the conversion starts in MOHG_MEASURE_SETTLE (see f_convert_measurement).
  */
-void f_measure_fingers(void);
+void f_begin_measurement(uint8_t first, uint8_t amount);
 
 /*
- * This function updates the heater states buffer.
- * I/O port states aren't changed.
+ * This function starts the conversion when the measurement has settled.
+ * It enables the ADC subsystem and starts the sweep of thermistor channels.
+ */
+void f_convert_measurement(void);
+
+/*
+ * This function finishes the measurement when the ADC sweep is over.
+ * It disables the ADC subsystem by itself.
+ * The resulting values are put into g_finger_temperatures variable.
+ * Heaters are unblanked after it.
  */
-void f_update_heater_states(void);
+void f_end_measurement(void);
 
 /*
- * This function disables all heaters.
- * Heater states buffer is not changed.
+ * This function updates the duties of heaters of the measured fingers by their controllers.
+ * The PWM applies them from the next tick.
  */
-void f_disable_heaters(void);
+void f_update_heater_duties(uint8_t first, uint8_t amount);
 
 /*
- * This function writes the heater states buffer to the I/O ports.
- * Heater states buffer is not changed.
+ * This function turns the heating on or off.
  */
-void f_flush_heaters(void);
+void f_set_heating_active(int is_active);
 
 /*
  * This function updates the display.
+ * The frame is drawn only when the values shown by the screen have changed.
  */
 void f_update_display(void);
 
 /*
- * This function calculated the average temperature.
+ * This function takes the values shown by the active screen.
  */
-double f_get_average_temperature(void);
+void f_get_ui_state(ui_state *state);
+
+/*
+ * This function makes the next display update draw the frame, even if nothing has changed.
+ */
+void f_invalidate_display(void);
+
+/*
+ * This function calculated the average temperature (in centidegrees).
+ */
+int16_t f_get_average_temperature(void);
 
 /*
  * This function handles input.
@@ -98,91 +156,225 @@ void f_handle_input(void);
  */
 void f_handle_button_press(uint8_t button_id);
 
+/*
+ * This task increments the seconds counter and measures the sleep time.
+ */
+void f_task_count_seconds(void);
 
+/*
+ * This task starts the measurement, unless it is in progress.
+ * The interleaved mode measures the fingers in turn.
+ */
+void f_task_measure(void);
 
-void f_measure_fingers(void) {
-    // disable the heaters before meausurement (only if heating is enabled)
-    if (g_is_heating_active) f_disable_heaters();
+/*
+ * This task starts the conversion when the measurement has settled
+ * and finishes the measurement when the ADC sweep is over.
+ */
+void f_task_poll_measurement(void);
+
+
+// indices of tasks in g_tasks
+#define TASK_SECONDS 0
+#define TASK_MEASURE 1
+#define TASK_MEASURE_POLL 2
+#define TASK_INPUT 3
+#define TASK_DISPLAY 4
+
+// the tasks of main loop, the measurement takes precedence over UI
+scheduler_task g_tasks[] = {
+    [TASK_SECONDS] = {
+        .run = f_task_count_seconds,
+        .period = TIMER_TICKS(1.0),
+        .priority = 4,
+    },
+    [TASK_MEASURE] = {
+        .run = f_task_measure,
+#if MOHG_MEASURE_MODE == MOHG_MEASURE_INTERLEAVED
+        .period = TIMER_TICKS(MOHG_MEASURE_INTERVAL / (THERMISTOR_AMOUNT)),
+#else
+        .period = TIMER_TICKS(MOHG_MEASURE_INTERVAL),
+#endif
+        .priority = 3,
+    },
+    [TASK_MEASURE_POLL] = {
+        .run = f_task_poll_measurement,
+        .period = 0,
+        .priority = 3,
+    },
+    [TASK_INPUT] = {
+        .run = f_handle_input,
+        .period = 0,
+        .priority = 1,
+    },
+    [TASK_DISPLAY] = {
+        .run = f_update_display,
+        .period = TIMER_TICKS(MOHG_DISPLAY_INTERVAL),
+        .priority = 0,
+    },
+};
+// the amount of tasks
+#define TASK_AMOUNT (sizeof(g_tasks) / sizeof(g_tasks[0]))
+
+
+
+void f_begin_measurement(uint8_t first, uint8_t amount) {
+    g_measure_first = first;
+    g_measure_amount = amount;
+
+    // turn the heaters of measured fingers off before meausurement
+    f_pwm_blank(((1 << amount) - 1) << first);
 
     // enable thermistors supply
-    SET_PIN_STATE(
+    HAL_gpio_write(
         PORT_OUTPUT_DEVICES,
         OUTPUT_DEVICE_THERMISTORS_SWITCH,
         1);
 
+    // the next tick may come at once, so one more is waited for
+    g_measure_settle_tick = f_timer_get_ticks() + TIMER_TICKS(MOHG_MEASURE_SETTLE) + 1;
+    g_measure_stage = MEASURE_SETTLING;
+}
+
+void f_convert_measurement(void) {
     // enable ADC
     f_enable_ADC();
 
-    // measure all thermistors
-    for (int i = 0; i < THERMISTOR_AMOUNT; i++) {
-        // make one measurement to increase the fidelity
-        f_read_ADC(THERMISTOR_PINS[i]);
+    // measure the thermistors in background
+    f_start_ADC_sweep(
+        &THERMISTOR_PINS[g_measure_first],
+        g_measure_amount,
+        FILTER_OVERSAMPLE,
+        &g_thermistor_samples[g_measure_first]);
+    g_measure_stage = MEASURE_CONVERTING;
+}
+
+void f_end_measurement(void) {
+    g_measure_stage = MEASURE_IDLE;
+
+    // disable ADC
+    f_disable_ADC();
+
+    // disable thermistors supply
+    HAL_gpio_write(
+        PORT_OUTPUT_DEVICES,
+        OUTPUT_DEVICE_THERMISTORS_SWITCH,
+        0);
+
+    // the samples are taken, turn the heaters back on with their old duties,
+    // so they aren't off during the conversion
+    f_pwm_blank(0);
 
-        // read the ADC value
-        double adc_val = f_read_ADC(THERMISTOR_PINS[i]);
+    // convert the samples to temperatures
+    for (uint8_t i = g_measure_first; i < g_measure_first + g_measure_amount; i++) {
+        PROFILE_BEGIN(PROFILE_FILTER);
 
-        // measure the resistance
+        // the filtered ADC value (with THERMISTOR_FINE_BITS fraction bits)
+        uint16_t adc_fine = f_filter_update(&g_thermistor_filters[i], g_thermistor_samples[i]);
+
+#ifdef MOHG_THERMISTOR_FLOAT
+        // the reference calculation, pulls the float math into firmware
         double r = f_calculate_resistance(
-            adc_val,
+            (double)adc_fine / (1 << THERMISTOR_FINE_BITS),
             MOHG_THERMISTOR_DIVIDER_R);
 
-        // measure the temperature
-        g_finger_temperatures[i] = f_calculate_temperature(
+        g_finger_temperatures[i] = 100.0 * f_calculate_temperature(
             MOHG_THERMISTOR_B,
             MOHG_THERMISTOR_R,
             r,
             MOHG_THERMISTOR_T);
-    }
+#else
+        // measure the temperature
+        g_finger_temperatures[i] = f_thermistor_centidegrees_fine(adc_fine);
+#endif
 
-    // disable ADC
-    f_disable_ADC();
+        PROFILE_END(PROFILE_FILTER);
+    }
 
-    // disable thermistors supply
-    SET_PIN_STATE(
-        PORT_OUTPUT_DEVICES,
-        OUTPUT_DEVICE_THERMISTORS_SWITCH,
-        0);
+    // the new duties
+    f_update_heater_duties(g_measure_first, g_measure_amount);
+}
 
-    // update the heaters buffer
-    f_update_heater_states();
+void f_update_heater_duties(uint8_t first, uint8_t amount) {
+    for (uint8_t i = first; i < first + amount; i++) {
+        uint8_t duty = f_pid_update(
+            &g_heater_controllers[i],
+            g_target_temperature * 100,
+            g_finger_temperatures[i]);
 
-    // flush the heaters buffer (only if heating is enabled)
-    if (g_is_heating_active) f_flush_heaters();
+        f_pwm_set_duty(i, duty);
+    }
 }
 
-void f_update_heater_states(void) {
-    // iterate through all thermistors
-    for (int i = 0; i < THERMISTOR_AMOUNT; i++) {
-        // current temperature
-        double temperature = g_finger_temperatures[i];
-
-        // check heater state to decide what logic should we follow
-        if (g_heater_states[i]) {
-            // the heater is on, check if we should turn it off (in buffer)
-            if (temperature >= g_target_temperature)
-                g_heater_states[i] = 0;
-        } else {
-            // the heater is off, check if we should turn it on (in buffer)
-            if (temperature <= g_target_temperature - TEMPERATURE_GAP)
-                g_heater_states[i] = 1;
-        }
+void f_set_heating_active(int is_active) {
+    g_is_heating_active = is_active;
+
+    // the history of controllers is stale after a pause
+    if (is_active) {
+        for (uint8_t i = 0; i < THERMISTOR_AMOUNT; i++)
+            f_pid_reset(&g_heater_controllers[i]);
     }
+
+    f_pwm_set_enabled(is_active);
 }
 
-void f_disable_heaters(void) {
-    for (int i = 0; i < THERMISTOR_AMOUNT; i++) {
-        SET_PIN_STATE(PORT_OUTPUT_DEVICES, HEATER_PINS[i], 0);
+void f_get_ui_state(ui_state *state) {
+    // the padding is compared too
+    memset(state, 0, sizeof(*state));
+
+    state->menu = g_active_menu;
+    state->is_heating_active = g_is_heating_active;
+
+    if (g_active_menu == MENU_MAIN) {
+        state->target = g_target_temperature;
+        state->average_temperature = f_get_average_temperature() / 100;
+    } else if (g_debug_menu_page == DEBUG_MEUN_MONITOR) {
+        state->debug_page = g_debug_menu_page;
+
+        uint8_t col_w = __SSD1306_WIDTH / THERMISTOR_AMOUNT;
+
+        for (uint8_t i = 0; i < THERMISTOR_AMOUNT; i++)
+            state->temperatures[i] = g_finger_temperatures[i] / 100;
+
+        // the bars are drawn only when heating, a bar of 0 pixels is still drawn
+        if (g_is_heating_active) {
+            for (uint8_t i = 0; i < HEATER_AMOUNT; i++) {
+                uint8_t duty = f_pwm_get_duty(i);
+                uint8_t achieved = f_pwm_get_achieved(i);
+
+                if (duty) state->duty_bars[i] = 1 + (uint16_t)col_w * duty / MOHG_PWM_STEPS;
+                if (achieved) state->achieved_bars[i] = 1 + (uint16_t)col_w * achieved / MOHG_PWM_STEPS;
+            }
+        }
+    } else {
+        state->debug_page = g_debug_menu_page;
     }
 }
 
-void f_flush_heaters(void) {
-    for (int i = 0; i < THERMISTOR_AMOUNT; i++) {
-        // write the buffered state to the I/O port
-        SET_PIN_STATE(PORT_OUTPUT_DEVICES, HEATER_PINS[i], g_heater_states[i]);
-    }
+void f_invalidate_display(void) {
+    g_is_ui_drawn = 0;
+
+    f_scheduler_trigger(&g_tasks[TASK_DISPLAY]);
 }
 
 void f_update_display(void) {
+    // nothing has changed since the last frame
+    PROFILE_BEGIN(PROFILE_DISPLAY_SKIPPED);
+
+    ui_state state;
+    f_get_ui_state(&state);
+
+    if (g_is_ui_drawn && memcmp(&state, &g_ui_drawn, sizeof(state)) == 0) {
+        g_skipped_frames++;
+        PROFILE_END(PROFILE_DISPLAY_SKIPPED);
+        return;
+    }
+
+    g_ui_drawn = state;
+    g_is_ui_drawn = 1;
+
+    PROFILE_BEGIN(PROFILE_DISPLAY);
+
     // clear screen
     SSD1306_graphics_fill(0);
 
@@ -191,104 +383,101 @@ void f_update_display(void) {
         case MENU_MAIN:
         // Main menu
         {
-            // dimensions of strings to print
-            uint16_t temp_w, temp_h;
-
             // decrease
             if (g_target_temperature > TEMPERATURE_MIN) {
-                BMP_calculate_string_dimensions(
-                    STR_DECREASE_TEMP_TITLE,
-                    &temp_w,
-                    &temp_h,
-                    BMP_default_symbol_resolver);
-
-                SSD1306_graphics_text(
-                    STR_DECREASE_TEMP_TITLE,
+                SSD1306_graphics_label_aligned(
+                    LABEL_DECREASE,
+                    LABEL_DECREASE_W,
+                    LABEL_DECREASE_H,
                     0,
-                    __SSD1306_HEIGHT - temp_h,
-                    BMP_default_symbol_resolver);
+                    __SSD1306_HEIGHT,
+                    SSD1306_ALIGN_LEFT | SSD1306_ALIGN_BOTTOM);
             }
 
             // increase
             if (g_target_temperature < TEMPERATURE_MAX) {
-                BMP_calculate_string_dimensions(
-                    STR_INCREASE_TEMP_TITLE,
-                    &temp_w,
-                    &temp_h,
-                    BMP_default_symbol_resolver);
-
-                SSD1306_graphics_text(
-                    STR_INCREASE_TEMP_TITLE,
-                    __SSD1306_WIDTH - temp_w,
-                    __SSD1306_HEIGHT - temp_h,
-                    BMP_default_symbol_resolver);
+                SSD1306_graphics_label_aligned(
+                    LABEL_INCREASE,
+                    LABEL_INCREASE_W,
+                    LABEL_INCREASE_H,
+                    __SSD1306_WIDTH,
+                    __SSD1306_HEIGHT,
+                    SSD1306_ALIGN_RIGHT | SSD1306_ALIGN_BOTTOM);
             }
 
             // start/stop
-            const char *switch_text = 
-                g_is_heating_active ? STR_STOP_TITLE : STR_START_TITLE;
-
-            BMP_calculate_string_dimensions(
-                switch_text,
-                &temp_w,
-                &temp_h,
-                BMP_default_symbol_resolver);
-
-            SSD1306_graphics_text(
-                switch_text,
-                __SSD1306_WIDTH / 2 - temp_w / 2,
-                __SSD1306_HEIGHT - temp_h,
-                BMP_default_symbol_resolver);
+            if (g_is_heating_active) {
+                SSD1306_graphics_label_aligned(
+                    LABEL_STOP,
+                    LABEL_STOP_W,
+                    LABEL_STOP_H,
+                    __SSD1306_WIDTH / 2,
+                    __SSD1306_HEIGHT,
+                    SSD1306_ALIGN_HCENTER | SSD1306_ALIGN_BOTTOM);
+            } else {
+                SSD1306_graphics_label_aligned(
+                    LABEL_START,
+                    LABEL_START_W,
+                    LABEL_START_H,
+                    __SSD1306_WIDTH / 2,
+                    __SSD1306_HEIGHT,
+                    SSD1306_ALIGN_HCENTER | SSD1306_ALIGN_BOTTOM);
+            }
 
             // horizontal line
             SSD1306_graphics_hline(0, __SSD1306_WIDTH, __SSD1306_HEIGHT - 9, 1);
 
 
-            // current temperature text
-            char *result_str = malloc(64);
-            memset(result_str, 0, 64);
+            // current temperature text, only the values are drawn symbol by symbol
+            char target_str[8];
+            char now_str[8];
+            format_buffer text;
 
-            char *temp_str = malloc(16);
-            ltoa(g_target_temperature, temp_str, 10);
+            f_format_init(&text, target_str, sizeof(target_str));
+            f_format_int(&text, g_target_temperature);
+            f_format_char(&text, 'd');
 
-            strcat(result_str, "ЦЕЛЬ: ");
-            strcat(result_str, temp_str);
-            strcat(result_str, "d");
+            f_format_init(&text, now_str, sizeof(now_str));
+            f_format_centi(&text, f_get_average_temperature(), 0);
+            f_format_char(&text, 'd');
 
-            ltoa(f_get_average_temperature(), temp_str, 10);
-            strcat(result_str, "\nСЕЙЧАС: ");
-            strcat(result_str, temp_str);
-            strcat(result_str, "d");
+            // the widths of lines
+            uint16_t target_w =
+                LABEL_TARGET_W + SSD1306_text_width(target_str, BMP_default_symbol_width);
+            uint16_t now_w =
+                LABEL_NOW_W + SSD1306_text_width(now_str, BMP_default_symbol_width);
 
-            BMP_calculate_string_dimensions(
-                result_str,
-                &temp_w,
-                &temp_h,
-                BMP_default_symbol_resolver);
+            // both lines start at the same x, the block is centered
+            uint16_t block_w = target_w > now_w ? target_w : now_w;
+            uint16_t block_h = 9 + LABEL_NOW_H;
 
-            SSD1306_graphics_text(
-                result_str,
-                __SSD1306_WIDTH / 2 - temp_w / 2,
-                (__SSD1306_HEIGHT - 9) / 2 - temp_h / 2,
-                BMP_default_symbol_resolver);
+            int16_t text_x = __SSD1306_WIDTH / 2 - (int16_t)block_w / 2;
+            int16_t text_y = (__SSD1306_HEIGHT - 9) / 2 - (int16_t)block_h / 2;
 
-            free(result_str);
-            free(temp_str);
+            if (text_x < 0) text_x = 0;
+            if (text_y < 0) text_y = 0;
 
+            SSD1306_graphics_bitmap_P(
+                LABEL_TARGET, LABEL_TARGET_W, LABEL_TARGET_H, text_x, text_y);
+            SSD1306_graphics_text(
+                target_str, text_x + LABEL_TARGET_W, text_y, BMP_default_symbol_resolver);
 
+            SSD1306_graphics_bitmap_P(
+                LABEL_NOW, LABEL_NOW_W, LABEL_NOW_H, text_x, text_y + 9);
+            SSD1306_graphics_text(
+                now_str, text_x + LABEL_NOW_W, text_y + 9, BMP_default_symbol_resolver);
         }
         break;
         case MENU_DEBUG:
         // Debug menu
         if (g_debug_menu_page == DEBUG_MEUN_MONITOR) {
             // display text
-            SSD1306_graphics_text("МОНИТОР ДАТЧИКОВ", 0, 0, BMP_default_symbol_resolver);
+            SSD1306_graphics_bitmap_P(LABEL_MONITOR, LABEL_MONITOR_W, LABEL_MONITOR_H, 0, 0);
             SSD1306_graphics_hline(0, __SSD1306_WIDTH, 8, 1);
             
             // the string to be displayed
-            char *res_str = malloc(128);
-            // the temp string for temperature values
-            char *val_str = malloc(16);
+            char res_str[16];
+            format_buffer text;
 
             // width of column
             uint8_t col_w = __SSD1306_WIDTH / THERMISTOR_AMOUNT;
@@ -305,113 +494,68 @@ void f_update_display(void) {
 
                 // WRITE INFO ABOUT HEATER
 
-                // fill the resulting string with zeros
-                memset(res_str, 0, 128);
-
-                // heater number to string
-                val_str = ltoa(
-                    i + 1,
-                    val_str,
-                    10);
-
-                strcat(res_str, "#");
-                strcat(res_str, val_str);
-                strcat(res_str, ":");
+                // heater number
+                f_format_init(&text, res_str, sizeof(res_str));
+                f_format_char(&text, '#');
+                f_format_int(&text, i + 1);
+                f_format_char(&text, ':');
 
                 SSD1306_graphics_text(res_str, col_w * i + 2, 10, BMP_default_symbol_resolver);
 
                 // TEMPERATURE
-                // fill the resulting string with zeros
-                memset(res_str, 0, 128);
-                // temperature to string
-                val_str = ltoa(
-                    g_finger_temperatures[i],
-                    val_str,
-                    10);
-                strcat(res_str, val_str);
-                strcat(res_str, "d");
+                f_format_init(&text, res_str, sizeof(res_str));
+                f_format_centi(&text, g_finger_temperatures[i], 0);
+                f_format_char(&text, 'd');
 
                 SSD1306_graphics_text(res_str, col_w * i + 2, 19, BMP_default_symbol_resolver);
 
-                // draw rectangle if on
-                if (GET_PIN_STATE(PIN_OUTPUT_DEVICES, HEATER_PINS[i])) {
+                // draw the requested duty of heater as the frame
+                // and the achieved one as the filling, if on
+                uint8_t duty = f_pwm_get_duty(i);
+                uint8_t achieved = f_pwm_get_achieved(i);
+
+                if (g_is_heating_active && duty) {
+                    SSD1306_graphics_rectangle(
+                        col_w * i,
+                        __SSD1306_HEIGHT - 4,
+                        col_w * i + (uint16_t)col_w * duty / MOHG_PWM_STEPS,
+                        __SSD1306_HEIGHT - 1,
+                        1);
+                }
+
+                if (g_is_heating_active && achieved) {
                     SSD1306_graphics_filled_rectangle(
                         col_w * i,
                         __SSD1306_HEIGHT - 4,
-                        col_w * (i + 1),
+                        col_w * i + (uint16_t)col_w * achieved / MOHG_PWM_STEPS,
                         __SSD1306_HEIGHT,
                         1);
                 }
 
             }
-
-            free(res_str);
-            free(val_str);
         } else if (g_debug_menu_page == DEBUG_MEUN_CONFIG) {
-            // the string to be displayed
-            char *res_str = malloc(128);
-            // the temp string for numeric values
-            char *val_str = malloc(16);
-
-            // fill the resulting string with zeros
-            memset(res_str, 0, 128);
-
-            // MAX TEMP
-            val_str = ltoa(
-                TEMPERATURE_MAX,
-                val_str,
-                10);
-
-            strcat(res_str, "МАКС: ");
-            strcat(res_str, val_str);
-            strcat(res_str, "d");
-
-            // MIN TEMP
-            val_str = ltoa(
-                TEMPERATURE_MIN,
-                val_str,
-                10);
-
-            strcat(res_str, "\nМИН: ");
-            strcat(res_str, val_str);
-            strcat(res_str, "d");
-
-            // TEMPERATURE GAP
-            val_str = ltoa(
-                TEMPERATURE_GAP,
-                val_str,
-                10);
-
-            strcat(res_str, "\nРАЗБРОС: ");
-            strcat(res_str, val_str);
-            strcat(res_str, "d");
-
-            // draw the text
-            SSD1306_graphics_text(
-                res_str,
-                0,
-                0,
-                BMP_default_symbol_resolver);
-
-
-            // free memory
-            free(res_str);
-            free(val_str);
+            // the page is built from configuration only, so it is pre-rasterized
+            SSD1306_graphics_bitmap_P(LABEL_CONFIG, LABEL_CONFIG_W, LABEL_CONFIG_H, 0, 0);
         }
         break;
     }
 
-    // render
+    PROFILE_END(PROFILE_DISPLAY);
+
+    // render, it counts the bytes of this frame only
+    PROFILE_BEGIN(PROFILE_RENDER);
     SSD1306_render();
+    PROFILE_END(PROFILE_RENDER);
+    PROFILE_VALUE(PROFILE_FRAME_BYTES, SSD1306_bytes_sent);
 }
 
-double f_get_average_temperature(void) {
-    double result = 0;
+int16_t f_get_average_temperature(void) {
+    int32_t result = 0;
 
-    for (int i = 0; i < THERMISTOR_AMOUNT; i++)
+    for (uint8_t i = 0; i < THERMISTOR_AMOUNT; i++)
         result += g_finger_temperatures[i];
 
-    return result / (double)THERMISTOR_AMOUNT;
+    return result / (int16_t)(THERMISTOR_AMOUNT);
 }
 
 void f_handle_input(void) {
@@ -428,12 +572,12 @@ void f_handle_input(void) {
         // check if cancellation
         if (g_bounce_cancellation_ticks[i] != 0) {
             // we're trying to cancel the bouncing effect
-            if (g_timer_ticks >= g_bounce_cancellation_ticks[i]) {
+            if ((int32_t)(g_timer_ticks - g_bounce_cancellation_ticks[i]) >= 0) {
                 // reset the cancellation timer
                 g_bounce_cancellation_ticks[i] = 0;
 
                 // check the level on pin
-                if (!GET_PIN_STATE(PIN_BUTTONS, button_pin)) {
+                if (!HAL_gpio_read(PORT_BUTTONS, button_pin)) {
                     // the button is held now, set holding begin time
                     g_button_hold_tick[i] = g_timer_ticks;
                     // no bouncing - the press is valid
@@ -448,9 +592,9 @@ void f_handle_input(void) {
         if (g_bounce_cancellation_ticks[i] == 0 &&
             g_button_hold_tick[i] == 0)
         {
-            if (!GET_PIN_STATE(PIN_BUTTONS, button_pin)) {
+            if (!HAL_gpio_read(PORT_BUTTONS, button_pin)) {
                 // start the timer for bouncing cancellation, 70ms delay
-                g_bounce_cancellation_ticks[i] = g_timer_ticks + f_timer_ticks(0.07);
+                g_bounce_cancellation_ticks[i] = g_timer_ticks + TIMER_TICKS(0.07);
             }
 
             continue;
@@ -458,7 +602,7 @@ void f_handle_input(void) {
 
         // if held, then check if released
         if (g_button_hold_tick[i] != 0) {
-            if (GET_PIN_STATE(PIN_BUTTONS, button_pin)) {
+            if (HAL_gpio_read(PORT_BUTTONS, button_pin)) {
                 // reset the hold timer
                 g_button_hold_tick[i] = 0;
             }
@@ -477,15 +621,12 @@ void f_handle_button_press(uint8_t button_id) {
                 g_target_temperature--;
                 // check if too high
                 if (g_target_temperature < TEMPERATURE_MIN) g_target_temperature = TEMPERATURE_MIN;
-
-                // force display update
-                g_timer_display_tick = 0;
             } else {
                 if (g_debug_menu_page == DEBUG_MEUN_MONITOR) g_debug_menu_page = DEBUG_MEUN_CONFIG;
                 else g_debug_menu_page = DEBUG_MEUN_MONITOR;
             }
-            // force display update
-            g_timer_display_tick = 0;
+            // update the display at once, it is redrawn if the change is shown
+            f_scheduler_trigger(&g_tasks[TASK_DISPLAY]);
         break;
         case BUTTON_MIDDLE_ID:
             // change the menu
@@ -493,13 +634,10 @@ void f_handle_button_press(uint8_t button_id) {
             else g_active_menu = MENU_DEBUG; */
 
             // switch the heating
-            g_is_heating_active = !g_is_heating_active;
-            // turn heaters on/off
-            if (g_is_heating_active) f_flush_heaters();
-            else f_disable_heaters();
+            f_set_heating_active(!g_is_heating_active);
 
-            // force display update
-            g_timer_display_tick = 0;
+            // update the display at once, it is redrawn if the change is shown
+            f_scheduler_trigger(&g_tasks[TASK_DISPLAY]);
         break;
         case BUTTON_RIGHT_ID:
             // main menu - increase temperature
@@ -508,15 +646,12 @@ void f_handle_button_press(uint8_t button_id) {
                 g_target_temperature++;
                 // check if too high
                 if (g_target_temperature > TEMPERATURE_MAX) g_target_temperature = TEMPERATURE_MAX;
-
-                // force display update
-                g_timer_display_tick = 0;
             } else if (MENU_DEBUG) {
                 if (g_debug_menu_page == DEBUG_MEUN_MONITOR) g_debug_menu_page = DEBUG_MEUN_CONFIG;
                 else g_debug_menu_page = DEBUG_MEUN_MONITOR;
             }
-            // force display update
-            g_timer_display_tick = 0;
+            // update the display at once, it is redrawn if the change is shown
+            f_scheduler_trigger(&g_tasks[TASK_DISPLAY]);
         break;
     }
 }
@@ -527,27 +662,32 @@ void f_handle_button_press(uint8_t button_id) {
  * 2. set the initial state of the ports
  * 3. initialize the timers
  * 4. initialize I2C
- * 5. initialize screen
- * 6. display the splash image
+ * 5. enable interrupts
+ * 6. initialize screen
+ * 7. display the splash image
  */
 void f_init() {
     // I/O init
     // BUTTONS
-    DDR_BUTTONS |= 0x00;
-    PORT_BUTTONS = 
-        1 << BUTTON_LEFT_PIN |
-        1 << BUTTON_MIDDLE_PIN |
-        1 << BUTTON_RIGHT_PIN;
+    // inputs with pull-up resistors
+    HAL_gpio_direction(PORT_BUTTONS, BUTTON_LEFT_PIN, 0);
+    HAL_gpio_direction(PORT_BUTTONS, BUTTON_MIDDLE_PIN, 0);
+    HAL_gpio_direction(PORT_BUTTONS, BUTTON_RIGHT_PIN, 0);
+    HAL_gpio_write(PORT_BUTTONS, BUTTON_LEFT_PIN, 1);
+    HAL_gpio_write(PORT_BUTTONS, BUTTON_MIDDLE_PIN, 1);
+    HAL_gpio_write(PORT_BUTTONS, BUTTON_RIGHT_PIN, 1);
 
     // OUTPUT DEVICES
-    // Thermistors switch
-    DDR_OUTPUT_DEVICES |= 1 << OUTPUT_DEVICE_THERMISTORS_SWITCH;
-    // Heaters
-    for (int i = 0; i < HEATER_AMOUNT; i++) {
-        DDR_OUTPUT_DEVICES |= 1 << HEATER_PINS[i];
+    // Thermistors switch, turned off
+    HAL_gpio_write(PORT_OUTPUT_DEVICES, OUTPUT_DEVICE_THERMISTORS_SWITCH, 0);
+    HAL_gpio_direction(PORT_OUTPUT_DEVICES, OUTPUT_DEVICE_THERMISTORS_SWITCH, 1);
+    // Heaters, turned off
+    for (uint8_t i = 0; i < HEATER_AMOUNT; i++) {
+        HAL_gpio_write(PORT_OUTPUT_DEVICES, HEATER_PINS[i], 0);
+        HAL_gpio_direction(PORT_OUTPUT_DEVICES, HEATER_PINS[i], 1);
     }
-    // Turn off all output devices
-    PORT_OUTPUT_DEVICES = 0x00;
+    // the PWM of heaters, before the timer ticks
+    f_pwm_init();
 
 
     // initialize the bouncing cancellation
@@ -560,16 +700,22 @@ void f_init() {
 
     // timers setup
     f_init_timers();
+    PROFILE_INIT();
 
     // I2C setup
     I2C_setup();
 
+    // the I2C transactions are sent by the interrupt
+    HAL_enable_interrupts();
+
     // display setup
     SSD1306_setup();
+    // send only the changed parts of frames
+    SSD1306_set_render_mode(SSD1306_RENDER_DIRTY);
 
     // draw the logo
     SSD1306_graphics_fill(1);
-    SSD1306_graphics_bitmap(
+    SSD1306_graphics_bitmap_P(
         BMP_LOGO,
         BMP_LOGO_W,
         BMP_LOGO_H,
@@ -577,7 +723,48 @@ void f_init() {
         __SSD1306_HEIGHT / 2 - BMP_LOGO_H / 2);
     SSD1306_render();
 
-    _delay_ms(3000);
+    HAL_delay_ms(3000);
+}
+
+
+void f_task_count_seconds(void) {
+    // the scheduler keeps the period, so the seconds don't drift
+    g_running_for++;
+
+    // how much of the last second the CPU has slept
+    g_sleep_permille = f_idle_get_sleep_permille();
+    PROFILE_VALUE(PROFILE_SLEEP, g_sleep_permille);
+}
+
+void f_task_measure(void) {
+    if (g_measure_stage != MEASURE_IDLE) return;
+
+    PROFILE_BEGIN(PROFILE_MEASURE);
+#if MOHG_MEASURE_MODE == MOHG_MEASURE_INTERLEAVED
+    f_begin_measurement(g_measure_next, 1);
+
+    if (++g_measure_next >= THERMISTOR_AMOUNT) g_measure_next = 0;
+#else
+    f_begin_measurement(0, THERMISTOR_AMOUNT);
+#endif
+    PROFILE_END(PROFILE_MEASURE);
+}
+
+void f_task_poll_measurement(void) {
+    // the heaters and the supply have settled
+    if (g_measure_stage == MEASURE_SETTLING
+            && (int32_t)(f_timer_get_ticks() - g_measure_settle_tick) >= 0) {
+        PROFILE_BEGIN(PROFILE_MEASURE);
+        f_convert_measurement();
+        PROFILE_END(PROFILE_MEASURE);
+    }
+
+    // the thermistors are swept
+    if (!(g_measure_stage == MEASURE_CONVERTING && f_is_ADC_sweep_done())) return;
+
+    PROFILE_BEGIN(PROFILE_MEASURE);
+    f_end_measurement();
+    PROFILE_END(PROFILE_MEASURE);
 }
 
 
@@ -585,40 +772,25 @@ int main(void) {
     // init the controller
     f_init();
 
+    // the first deadlines are counted from now
+    f_scheduler_init(g_tasks, TASK_AMOUNT);
+
     // main loop
     while (1) {
-        // timer tick check
-        if (f_check_timer_tick()) {
-            // increment timer ticks amount
-            g_timer_ticks++;
-        }
+        PROFILE_LOOP_ITERATION();
 
-        // user input handler
-        f_handle_input();
-
-        // seconds counter
-        if (f_timer_interval(g_timer_second_counter_tick, g_timer_ticks) >= 1.0) {
-            // update ticks
-            g_timer_second_counter_tick = g_timer_ticks;
-
-            // increment seconds
-            g_running_for++;
-        }
-
-        // measurements
-        if (f_timer_interval(g_timer_measure_tick, g_timer_ticks) >= MOHG_MEASURE_INTERVAL) {
-            // update the time of last temperature check
-            g_timer_measure_tick = g_timer_ticks;
-            f_measure_fingers();
-        }
-
-        // display update
-        if (f_timer_interval(g_timer_display_tick, g_timer_ticks) >= MOHG_DISPLAY_INTERVAL) {
-            g_timer_display_tick = g_timer_ticks;
-            f_update_display();
-        }
+        // the time of this iteration
+        g_timer_ticks = f_timer_get_ticks();
 
+        // run the tasks whose time has come
+        PROFILE_BEGIN(PROFILE_TASKS);
+        f_scheduler_run(g_tasks, TASK_AMOUNT);
+        PROFILE_END(PROFILE_TASKS);
 
+        // sleep till the next deadline, the interrupts wake the CPU earlier
+        // don't sleep if the sweep is over, the measurement must be finished
+        if (!(g_measure_stage == MEASURE_CONVERTING && f_is_ADC_sweep_done()))
+            f_idle(f_scheduler_next_deadline(g_tasks, TASK_AMOUNT));
     }
 
     return 0;
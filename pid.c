@@ -0,0 +1,73 @@
+#include "pid.h"
+
+#include "configuration.h"
+
+// the gains in fixed point (Q16, PWM steps per centidegree), calculated at compile time
+// the controller is updated every MOHG_MEASURE_INTERVAL
+#define PID_KP_Q16 ((int32_t)(MOHG_PID_KP / 100 * 65536 + 0.5))
+#define PID_KI_Q16 ((int32_t)(MOHG_PID_KI / 100 * MOHG_MEASURE_INTERVAL * 65536 + 0.5))
+#define PID_KD_Q16 ((int32_t)(MOHG_PID_KD / 100 / MOHG_MEASURE_INTERVAL * 65536 + 0.5))
+
+// the maximum output
+#define PID_OUTPUT_MAX ((int32_t)MOHG_PWM_STEPS << 16)
+
+// the limit of value multiplied by the gain, so the term stays within twice the maximum output
+// and the sum of terms can't overflow, the output is saturated well before it
+#define PID_LIMIT(gain_q16) ((gain_q16) > 2 * PID_OUTPUT_MAX / INT16_MAX ? (int16_t)(2 * PID_OUTPUT_MAX / (gain_q16)) : INT16_MAX)
+#define PID_ERROR_MAX PID_LIMIT(PID_KP_Q16)
+#define PID_CHANGE_MAX PID_LIMIT(PID_KD_Q16)
+
+
+// returns the value limited to -limit..limit
+static int16_t f_pid_limit(int32_t value, int16_t limit) {
+    if (value > limit) return limit;
+    if (value < -limit) return -limit;
+
+    return value;
+}
+
+
+/*
+ * Forget the history.
+ */
+void f_pid_reset(pid_state *pid) {
+    pid->integral = 0;
+    pid->previous = 0;
+    pid->is_started = 0;
+}
+
+/*
+ * Returns the duty (in PWM steps) for the temperatures (in centidegrees).
+ */
+uint8_t f_pid_update(pid_state *pid, int16_t target, int16_t temperature) {
+    int16_t error = f_pid_limit((int32_t)target - temperature, PID_ERROR_MAX);
+
+    // proportional
+    int32_t output = PID_KP_Q16 * error;
+
+    // derivative of temperature
+    if (pid->is_started)
+        output -= PID_KD_Q16 * f_pid_limit((int32_t)temperature - pid->previous, PID_CHANGE_MAX);
+
+    pid->previous = temperature;
+    pid->is_started = 1;
+
+    // integral, unless it pushes the saturated output further
+    int32_t integral = pid->integral + PID_KI_Q16 * error;
+
+    if (integral < 0) integral = 0;
+    if (integral > PID_OUTPUT_MAX) integral = PID_OUTPUT_MAX;
+
+    int32_t total = output + integral;
+
+    if (!(total > PID_OUTPUT_MAX && error > 0) && !(total < 0 && error < 0))
+        pid->integral = integral;
+
+    output += pid->integral;
+
+    if (output < 0) return 0;
+    if (output > PID_OUTPUT_MAX) return MOHG_PWM_STEPS;
+
+    // round to the nearest step
+    return (output + (1L << 15)) >> 16;
+}
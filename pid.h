@@ -0,0 +1,30 @@
+#ifndef MOHG__PID_H
+#define MOHG__PID_H
+
+#include <stdint.h>
+
+// the state of controller of one heater
+typedef struct {
+    // the integral term (in PWM steps, Q16)
+    int32_t integral;
+    // the previous temperature (in centidegrees)
+    int16_t previous;
+    // 1 if the previous temperature is known
+    uint8_t is_started;
+} pid_state;
+
+/*
+ * Forget the history, e.g. when the heating is turned on.
+ */
+void f_pid_reset(pid_state *pid);
+
+/*
+ * Returns the duty (in PWM steps) for the temperatures (in centidegrees).
+ * Call it every MOHG_MEASURE_INTERVAL.
+ * The derivative is taken from the temperature, so the target changes don't kick.
+ * The integral isn't accumulated while the output is saturated.
+ * The error and the temperature change are limited, so any temperatures are safe (e.g. a broken thermistor).
+ */
+uint8_t f_pid_update(pid_state *pid, int16_t target, int16_t temperature);
+
+#endif
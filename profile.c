@@ -0,0 +1,173 @@
+#include "profile.h"
+
+#ifdef MOHG_PROFILE
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "format.h"
+
+// the statistics of section
+typedef struct {
+    uint16_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t total;
+} profile_section;
+
+static const char *PROFILE_NAMES[PROFILE_SECTION_AMOUNT] = {
+    [PROFILE_LOOP] = "loop_period",
+    [PROFILE_TASKS] = "loop_tasks",
+    [PROFILE_MEASURE] = "measure",
+    [PROFILE_DISPLAY] = "update_display",
+    [PROFILE_RENDER] = "render",
+    [PROFILE_FRAME_BYTES] = "i2c_bytes_per_frame",
+    [PROFILE_FILTER] = "filter_sample",
+    [PROFILE_DISPLAY_SKIPPED] = "display_skipped",
+    [PROFILE_SLEEP] = "sleep_permille",
+};
+
+static profile_section g_profile_sections[PROFILE_SECTION_AMOUNT];
+
+// the high word of cycle counter
+static volatile uint16_t g_profile_overflows = 0;
+
+// the beginning of previous loop iteration and of the report interval
+static uint32_t g_profile_loop_begin = 0;
+static uint32_t g_profile_report_begin = 0;
+
+
+// reset the statistics
+static void f_profile_reset(void) {
+    for (uint8_t i = 0; i < PROFILE_SECTION_AMOUNT; i++) {
+        g_profile_sections[i].count = 0;
+        g_profile_sections[i].min = UINT32_MAX;
+        g_profile_sections[i].max = 0;
+        g_profile_sections[i].total = 0;
+    }
+}
+
+/*
+ * Send the string over USART.
+ */
+void f_profile_print(const char *str) {
+    for (uint8_t i = 0; str[i]; i++) {
+        while (!(UCSRA & 1 << UDRE));
+        UDR = str[i];
+    }
+}
+
+// print the statistics of all sections and reset them
+static void f_profile_report(void) {
+    char line[64];
+    format_buffer text;
+
+    for (uint8_t i = 0; i < PROFILE_SECTION_AMOUNT; i++) {
+        profile_section *s = &g_profile_sections[i];
+        if (s->count == 0) continue;
+
+        f_format_init(&text, line, sizeof(line));
+        f_format_str(&text, "profile,");
+        f_format_str(&text, PROFILE_NAMES[i]);
+        f_format_char(&text, ',');
+        f_format_int(&text, s->count);
+        f_format_char(&text, ',');
+        f_format_int(&text, s->min);
+        f_format_char(&text, ',');
+        f_format_int(&text, s->max);
+        f_format_char(&text, ',');
+        f_format_int(&text, s->total / s->count);
+        f_format_char(&text, '\n');
+
+        f_profile_print(line);
+    }
+
+    // the sections may be left out, so the end is marked
+    f_profile_print("profile_end\n");
+
+    f_profile_reset();
+}
+
+
+/*
+ * Start Timer1 and USART.
+ */
+void f_profile_init(void) {
+    f_profile_reset();
+
+    // Timer1 counts CPU cycles, overflows extend it to 32 bits
+    TCCR1A = 0;
+    TCCR1B = 1 << CS10;
+    TIMSK |= 1 << TOIE1;
+
+    // USART: transmitter only, 8N1
+    UBRRH = (F_CPU / 16 / PROFILE_BAUD - 1) >> 8;
+    UBRRL = (F_CPU / 16 / PROFILE_BAUD - 1) & 0xFF;
+    UCSRB = 1 << TXEN;
+    UCSRC = 1 << URSEL | 1 << UCSZ1 | 1 << UCSZ0;
+
+    g_profile_loop_begin = g_profile_report_begin = f_profile_cycles();
+}
+
+
+/*
+ * Returns the amount of CPU cycles since initialization.
+ */
+uint32_t f_profile_cycles(void) {
+    uint16_t high;
+    uint16_t low;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        low = TCNT1;
+        high = g_profile_overflows;
+
+        // the timer has overflowed, but the interrupt isn't handled yet
+        if ((TIFR & 1 << TOV1) && low < 0x8000) high++;
+    }
+
+    return (uint32_t)high << 16 | low;
+}
+
+
+/*
+ * Add the value to the statistics of section.
+ */
+void f_profile_add(uint8_t section, uint32_t value) {
+    profile_section *s = &g_profile_sections[section];
+
+    // keep the average meaningful
+    if (s->count == UINT16_MAX) return;
+
+    s->count++;
+    s->total += value;
+    if (value < s->min) s->min = value;
+    if (value > s->max) s->max = value;
+}
+
+
+/*
+ * Measure the loop period and print the report when it's time.
+ */
+void f_profile_loop(void) {
+    uint32_t now = f_profile_cycles();
+
+    f_profile_add(PROFILE_LOOP, now - g_profile_loop_begin);
+
+    if (now - g_profile_report_begin >= PROFILE_REPORT_INTERVAL * F_CPU) {
+        f_profile_report();
+
+        // the report itself isn't a part of the loop period
+        now = f_profile_cycles();
+        g_profile_report_begin = now;
+    }
+
+    g_profile_loop_begin = now;
+}
+
+
+ISR(TIMER1_OVF_vect) {
+    g_profile_overflows++;
+}
+
+#endif
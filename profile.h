@@ -0,0 +1,81 @@
+#ifndef MOHG__PROFILE_H
+#define MOHG__PROFILE_H
+
+#include <stdint.h>
+
+/*
+    Cycle profiling of the firmware hot paths (AVR only).
+
+    It is compiled in with -DMOHG_PROFILE (see benchmark.sh), otherwise
+    the macros are empty. Timer1 counts CPU cycles, the statistics are
+    printed over USART every PROFILE_REPORT_INTERVAL seconds as lines:
+        profile,<section>,<count>,<min>,<max>,<average>
+    The sections without samples are left out, the report ends with the line:
+        profile_end
+    The cycles of interrupts that happen inside a section are counted too.
+*/
+
+// the interval between reports (in seconds)
+#define PROFILE_REPORT_INTERVAL 5
+
+// the baud rate of USART
+#define PROFILE_BAUD 38400UL
+
+// the sections
+#define PROFILE_LOOP 0          // the period of main loop (including sleep)
+#define PROFILE_TASKS 1         // the tasks of one main loop iteration
+#define PROFILE_MEASURE 2       // starting and finishing the measurement
+#define PROFILE_DISPLAY 3       // f_update_display() without rendering
+#define PROFILE_RENDER 4        // SSD1306_render()
+#define PROFILE_FRAME_BYTES 5   // I2C bytes per frame (not cycles)
+#define PROFILE_FILTER 6        // filtering and converting one thermistor sample
+#define PROFILE_DISPLAY_SKIPPED 7   // f_update_display() that finds nothing changed
+#define PROFILE_SLEEP 8         // the part of each second spent sleeping (in 1/1000, not cycles)
+#define PROFILE_SECTION_AMOUNT 9
+
+#ifdef MOHG_PROFILE
+
+/*
+ * Start Timer1 and USART.
+ */
+void f_profile_init(void);
+
+/*
+ * Returns the amount of CPU cycles since initialization.
+ * The counter overflows, so compare only the differences.
+ */
+uint32_t f_profile_cycles(void);
+
+/*
+ * Add the value to the statistics of section.
+ */
+void f_profile_add(uint8_t section, uint32_t value);
+
+/*
+ * Send the string over USART.
+ */
+void f_profile_print(const char *str);
+
+/*
+ * Call it at the beginning of every main loop iteration.
+ * It measures the loop period and prints the report when it's time.
+ */
+void f_profile_loop(void);
+
+#define PROFILE_INIT() f_profile_init()
+#define PROFILE_BEGIN(section) uint32_t __profile_begin_##section = f_profile_cycles()
+#define PROFILE_END(section) f_profile_add(section, f_profile_cycles() - __profile_begin_##section)
+#define PROFILE_VALUE(section, value) f_profile_add(section, value)
+#define PROFILE_LOOP_ITERATION() f_profile_loop()
+
+#else
+
+#define PROFILE_INIT()
+#define PROFILE_BEGIN(section)
+#define PROFILE_END(section)
+#define PROFILE_VALUE(section, value)
+#define PROFILE_LOOP_ITERATION()
+
+#endif
+
+#endif
@@ -0,0 +1,173 @@
+#include "pwm.h"
+
+#include "HAL/HAL.h"
+#include "configuration.h"
+
+// the requested duties of heaters (in PWM steps)
+static volatile uint8_t g_pwm_duties[HEATER_AMOUNT];
+// the steps heaters were on in their last periods
+static volatile uint8_t g_pwm_achieved[HEATER_AMOUNT];
+// the step of period
+static volatile uint8_t g_pwm_step = 0;
+
+static volatile uint8_t g_pwm_is_enabled = 0;
+// the heaters turned off for the measurement
+static volatile uint8_t g_pwm_blanked = 0;
+
+// the steps heaters are still to be on in their current periods
+static uint8_t g_pwm_credits[HEATER_AMOUNT];
+// the steps heaters have been on in their current periods
+static uint8_t g_pwm_granted[HEATER_AMOUNT];
+
+// the steps the periods of heaters begin at, they are spread over the period
+static uint8_t g_pwm_phases[HEATER_AMOUNT];
+
+// the bits of heater pins in the port
+static uint8_t g_pwm_masks[HEATER_AMOUNT];
+static uint8_t g_pwm_all_mask = 0;
+
+
+// turn the heater pins in mask off at once
+static void f_pwm_turn_off(uint8_t mask) {
+    // the interrupt writes the same port
+    HAL_disable_interrupts();
+    HAL_gpio_write_mask(PORT_OUTPUT_DEVICES, mask, 0);
+    HAL_enable_interrupts();
+}
+
+
+/*
+ * Set up the masks of heater pins and the phases.
+ */
+void f_pwm_init(void) {
+    for (uint8_t i = 0; i < HEATER_AMOUNT; i++) {
+        g_pwm_masks[i] = 1 << HEATER_PINS[i];
+        g_pwm_all_mask |= g_pwm_masks[i];
+
+        g_pwm_phases[i] = i * MOHG_PWM_STEPS / (HEATER_AMOUNT);
+
+        g_pwm_duties[i] = 0;
+        g_pwm_achieved[i] = 0;
+        g_pwm_credits[i] = 0;
+        g_pwm_granted[i] = 0;
+    }
+}
+
+/*
+ * Set the duty of heater (in PWM steps).
+ */
+void f_pwm_set_duty(uint8_t heater, uint8_t duty) {
+    if (duty > MOHG_PWM_STEPS) duty = MOHG_PWM_STEPS;
+
+    g_pwm_duties[heater] = duty;
+}
+
+/*
+ * Returns the duty of heater (in PWM steps).
+ */
+uint8_t f_pwm_get_duty(uint8_t heater) {
+    return g_pwm_duties[heater];
+}
+
+/*
+ * Returns the steps the heater was on in its last period.
+ */
+uint8_t f_pwm_get_achieved(uint8_t heater) {
+    return g_pwm_achieved[heater];
+}
+
+/*
+ * Enable or disable all heaters.
+ */
+void f_pwm_set_enabled(uint8_t is_enabled) {
+    g_pwm_is_enabled = is_enabled;
+
+    if (!is_enabled) f_pwm_turn_off(g_pwm_all_mask);
+}
+
+/*
+ * Turn the heaters in mask off for the measurement, the others back on.
+ */
+void f_pwm_blank(uint8_t heaters) {
+    g_pwm_blanked = heaters;
+
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < HEATER_AMOUNT; i++)
+        if (heaters & 1 << i) mask |= g_pwm_masks[i];
+
+    if (mask) f_pwm_turn_off(mask);
+}
+
+/*
+ * One step of PWM.
+ */
+void f_pwm_tick(void) {
+    uint8_t step = g_pwm_step + 1;
+    if (step >= MOHG_PWM_STEPS) step = 0;
+    g_pwm_step = step;
+
+    // the heaters that want to be on and their amount
+    uint8_t wanting = 0;
+    uint8_t wanting_amount = 0;
+
+    // the blanked heaters keep their credits and catch up after the measurement
+    uint8_t blanked = g_pwm_blanked;
+
+    for (uint8_t i = 0; i < HEATER_AMOUNT; i++) {
+        // the period of heater begins
+        if (step == g_pwm_phases[i]) {
+            g_pwm_achieved[i] = g_pwm_granted[i];
+            g_pwm_granted[i] = 0;
+            g_pwm_credits[i] = g_pwm_duties[i];
+        }
+
+        if (g_pwm_credits[i] && !(blanked & 1 << i)) {
+            wanting |= 1 << i;
+            wanting_amount++;
+        }
+    }
+
+    if (!g_pwm_is_enabled) wanting = 0;
+
+    // too many, the ones with the least slack till the end of their periods go first
+    if (wanting && wanting_amount > MOHG_PWM_MAX_ACTIVE) {
+        uint8_t chosen = 0;
+
+        for (uint8_t n = 0; n < MOHG_PWM_MAX_ACTIVE; n++) {
+            uint8_t best = 0;
+            int16_t best_slack = INT16_MAX;
+
+            for (uint8_t i = 0; i < HEATER_AMOUNT; i++) {
+                if (!(wanting & 1 << i) || (chosen & 1 << i)) continue;
+
+                // the steps left in the period of heater, including this one
+                int16_t left = (int16_t)g_pwm_phases[i] - step;
+                if (left <= 0) left += MOHG_PWM_STEPS;
+
+                int16_t slack = left - g_pwm_credits[i];
+
+                if (slack < best_slack) {
+                    best = i;
+                    best_slack = slack;
+                }
+            }
+
+            chosen |= 1 << best;
+        }
+
+        wanting = chosen;
+    }
+
+    // the heaters that are on at this step
+    uint8_t on = 0;
+
+    for (uint8_t i = 0; i < HEATER_AMOUNT; i++) {
+        if (!(wanting & 1 << i)) continue;
+
+        g_pwm_credits[i]--;
+        g_pwm_granted[i]++;
+        on |= g_pwm_masks[i];
+    }
+
+    HAL_gpio_write_mask(PORT_OUTPUT_DEVICES, g_pwm_all_mask, on);
+}
@@ -0,0 +1,61 @@
+#ifndef MOHG__PWM_H
+#define MOHG__PWM_H
+
+#include <stdint.h>
+
+// blank all heaters, see f_pwm_blank
+#define PWM_BLANK_ALL 0xFF
+
+/*
+    Software PWM of heaters.
+    The period is MOHG_PWM_STEPS timer ticks, the tick interrupt steps it.
+    The duty of heater is the amount of steps it is on in its period.
+
+    The periods of heaters begin at different steps, so they don't switch on
+    together. No more than MOHG_PWM_MAX_ACTIVE heaters are on at once: when
+    more want to be on, the ones with the least slack till the end of their
+    periods are chosen. All duties are achieved if their sum doesn't exceed
+    MOHG_PWM_MAX_ACTIVE * MOHG_PWM_STEPS, otherwise the achieved duty shows
+    how much each heater got.
+*/
+
+/*
+ * Set up the masks of heater pins, all heaters are off.
+ */
+void f_pwm_init(void);
+
+/*
+ * Set the duty of heater (in PWM steps), it is applied from the next period of heater.
+ */
+void f_pwm_set_duty(uint8_t heater, uint8_t duty);
+
+/*
+ * Returns the duty of heater (in PWM steps).
+ */
+uint8_t f_pwm_get_duty(uint8_t heater);
+
+/*
+ * Returns the steps the heater was on in its last period (the achieved duty).
+ */
+uint8_t f_pwm_get_achieved(uint8_t heater);
+
+/*
+ * Enable or disable all heaters, they are turned off at once.
+ * Call it with interrupts enabled.
+ */
+void f_pwm_set_enabled(uint8_t is_enabled);
+
+/*
+ * Turn the heaters off for the measurement or back on, the duties are kept.
+ * The bits of heaters are the heaters to turn off (PWM_BLANK_ALL for all of them),
+ * 0 turns all of them back on.
+ * Call it with interrupts enabled.
+ */
+void f_pwm_blank(uint8_t heaters);
+
+/*
+ * One step of PWM, called by the timer tick interrupt.
+ */
+void f_pwm_tick(void);
+
+#endif
@@ -0,0 +1,106 @@
+#include "scheduler.h"
+
+#include "timers.h"
+
+
+/*
+ * Prepare the tasks: reset the statistics and set the first deadlines
+ * one period from now.
+ */
+void f_scheduler_init(scheduler_task *tasks, uint8_t amount) {
+    uint32_t now = f_timer_get_ticks();
+
+    for (uint8_t i = 0; i < amount; i++) {
+        tasks[i].next_deadline = now + tasks[i].period;
+        tasks[i].missed_deadlines = 0;
+        tasks[i].overruns = 0;
+        tasks[i].max_runtime = 0;
+    }
+}
+
+
+/*
+ * Run the task and update its deadline and statistics.
+ */
+static void f_scheduler_run_task(scheduler_task *task, uint32_t now) {
+    task->run();
+
+    // statistics
+    uint32_t runtime = f_timer_get_ticks() - now;
+    if (runtime > task->max_runtime) task->max_runtime = runtime;
+
+    // runs on every pass, there are no deadlines
+    if (task->period == 0) return;
+
+    if (runtime > task->period) task->overruns++;
+
+    // the next deadline, the periods that are already over are skipped
+    uint32_t lateness = now - task->next_deadline;
+    if (lateness >= task->period) {
+        uint32_t skipped = lateness / task->period;
+
+        task->missed_deadlines += skipped;
+        task->next_deadline += skipped * task->period;
+    }
+
+    task->next_deadline += task->period;
+}
+
+
+/*
+ * Make one pass through the tasks and run the ones whose deadline has come.
+ */
+void f_scheduler_run(scheduler_task *tasks, uint8_t amount) {
+    // the tasks that have already run on this pass
+    uint32_t done = 0;
+
+    while (1) {
+        // the previous tasks may have taken some time
+        uint32_t now = f_timer_get_ticks();
+
+        // find the due task with the greatest priority
+        int8_t next = -1;
+        for (uint8_t i = 0; i < amount; i++) {
+            if (done & (1UL << i)) continue;
+
+            // not yet, the tasks without a period are always due
+            if (tasks[i].period && (int32_t)(now - tasks[i].next_deadline) < 0) continue;
+
+            if (next < 0 || tasks[i].priority > tasks[next].priority) next = i;
+        }
+
+        // nothing to do
+        if (next < 0) return;
+
+        done |= 1UL << next;
+        f_scheduler_run_task(&tasks[next], now);
+    }
+}
+
+
+/*
+ * Returns the earliest deadline of the tasks with a period.
+ */
+uint32_t f_scheduler_next_deadline(scheduler_task *tasks, uint8_t amount) {
+    uint32_t now = f_timer_get_ticks();
+
+    // the distance from now to the earliest deadline, the counter overflows
+    int32_t earliest = INT32_MAX;
+
+    for (uint8_t i = 0; i < amount; i++) {
+        if (tasks[i].period == 0) continue;
+
+        int32_t distance = (int32_t)(tasks[i].next_deadline - now);
+        if (distance < earliest) earliest = distance;
+    }
+
+    return now + earliest;
+}
+
+
+/*
+ * Make the task run on the next pass.
+ */
+void f_scheduler_trigger(scheduler_task *task) {
+    task->next_deadline = f_timer_get_ticks();
+}
@@ -0,0 +1,52 @@
+#ifndef MOHG__SCHEDULER_H
+#define MOHG__SCHEDULER_H
+
+#include <stdint.h>
+
+// the periodic task of main loop
+typedef struct {
+    // the function of task
+    void (*run)(void);
+    // the period of task (in timer ticks), 0 - run on every pass
+    uint32_t period;
+    // the tasks with greater priority run first
+    uint8_t priority;
+
+    // the tick the task should run at
+    uint32_t next_deadline;
+
+    // the amount of periods skipped because the task was late
+    uint16_t missed_deadlines;
+    // the amount of runs longer than the period
+    uint16_t overruns;
+    // the longest run (in timer ticks)
+    uint32_t max_runtime;
+} scheduler_task;
+
+// the maximum amount of tasks
+#define SCHEDULER_MAX_TASKS 32
+
+/*
+ * Prepare the tasks: reset the statistics and set the first deadlines
+ * one period from now.
+ */
+void f_scheduler_init(scheduler_task *tasks, uint8_t amount);
+
+/*
+ * Make one pass through the tasks and run the ones whose deadline has come.
+ * The tasks run in the order of priority, every task runs once per pass at most.
+ */
+void f_scheduler_run(scheduler_task *tasks, uint8_t amount);
+
+/*
+ * Returns the earliest deadline of the tasks with a period.
+ * The tasks without a period run on every pass, they don't have deadlines.
+ */
+uint32_t f_scheduler_next_deadline(scheduler_task *tasks, uint8_t amount);
+
+/*
+ * Make the task run on the next pass.
+ */
+void f_scheduler_trigger(scheduler_task *task);
+
+#endif
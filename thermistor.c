@@ -0,0 +1,47 @@
+#include "thermistor.h"
+
+#include <avr/pgmspace.h>
+
+#include "thermistor_table.h"
+
+// the fine ADC values between the entries of the table, the fraction bits are interpolated too
+#define FINE_STEP_BITS (THERMISTOR_TABLE_STEP_BITS + THERMISTOR_FINE_BITS)
+
+
+/*
+ * Convert the ADC value of thermistor to temperature.
+ * Returns the temperature in centidegrees Celcius.
+ */
+int16_t f_thermistor_centidegrees(uint16_t adc_val) {
+    // ADC is 10-bit
+    if (adc_val > 1023) adc_val = 1023;
+
+    // the neighbour entries of the table
+    uint8_t index = adc_val >> THERMISTOR_TABLE_STEP_BITS;
+    uint8_t fraction = adc_val & ((1 << THERMISTOR_TABLE_STEP_BITS) - 1);
+
+    int16_t t1 = pgm_read_word(&THERMISTOR_TABLE[index]);
+    int16_t t2 = pgm_read_word(&THERMISTOR_TABLE[index + 1]);
+
+    // linear interpolation, the table is ascending
+    return t1 + (int16_t)(((uint32_t)(t2 - t1) * fraction) >> THERMISTOR_TABLE_STEP_BITS);
+}
+
+/*
+ * Convert the ADC value with THERMISTOR_FINE_BITS fraction bits to temperature.
+ * Returns the temperature in centidegrees Celcius.
+ */
+int16_t f_thermistor_centidegrees_fine(uint16_t adc_fine) {
+    // ADC is 10-bit
+    if (adc_fine > 1023U << THERMISTOR_FINE_BITS) adc_fine = 1023U << THERMISTOR_FINE_BITS;
+
+    // the neighbour entries of the table
+    uint8_t index = adc_fine >> FINE_STEP_BITS;
+    uint16_t fraction = adc_fine & ((1 << FINE_STEP_BITS) - 1);
+
+    int16_t t1 = pgm_read_word(&THERMISTOR_TABLE[index]);
+    int16_t t2 = pgm_read_word(&THERMISTOR_TABLE[index + 1]);
+
+    // linear interpolation, the table is ascending
+    return t1 + (int16_t)(((uint32_t)(t2 - t1) * fraction) >> FINE_STEP_BITS);
+}
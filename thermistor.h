@@ -0,0 +1,22 @@
+#ifndef MOHG__THERMISTOR_H
+#define MOHG__THERMISTOR_H
+
+#include <stdint.h>
+
+/*
+ * Convert the ADC value of thermistor to temperature.
+ * Uses the table generated from configuration.h by tools/gen_thermistor_table.c.
+ * Returns the temperature in centidegrees Celcius.
+ */
+int16_t f_thermistor_centidegrees(uint16_t adc_val);
+
+// the fraction bits of fine ADC values (oversampled and filtered, see filter.h)
+#define THERMISTOR_FINE_BITS 6
+
+/*
+ * Convert the ADC value with THERMISTOR_FINE_BITS fraction bits to temperature.
+ * Returns the temperature in centidegrees Celcius.
+ */
+int16_t f_thermistor_centidegrees_fine(uint16_t adc_fine);
+
+#endif
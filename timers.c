@@ -1,58 +1,72 @@
 #include "timers.h"
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "pwm.h"
+
+// the amount of timer ticks since initialization
+static volatile uint32_t g_timer_counter = 0;
 
 /*
  * Initialize the timers
  */
 void f_init_timers() {
-    // Set the 8-bit timer clock source to system clock / 128
-    TCCR0 = 1 << CS02;
+    // Clear the 8-bit timer on compare match, clock source is system clock / 64
+    TCCR0 = 1 << WGM01 | 1 << CS01 | 1 << CS00;
+
+    // one compare match per tick
+    OCR0 = TIMER_COUNTS_PER_TICK - 1;
+
+    // enable the compare match interrupt
+    TIMSK |= 1 << OCIE0;
 }
 
 
 /*
- * Check if one clock cycle of 8-bit timer has passed.
- * Returns 1 if timer has ticked.
- * Resets the interrupt flag of 8-bit timer.
+ * Returns the amount of timer ticks since initialization.
  */
-int f_check_timer_tick() {
-    // check if Timer OVerflow flag is set
-    int tick = TIFR & 1 << TOV0;
+uint32_t f_timer_get_ticks() {
+    uint32_t ticks;
 
-    // reset the Timer OVerflow flag if timer has ticked
-    if (tick) TIFR |= 1 << TOV0;
+    // 32-bit value can't be read at once
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ticks = g_timer_counter;
+    }
 
-    return tick;
+    return ticks;
 }
 
 
 /*
- * Returns the time between two timer ticks (in seconds)
+ * Returns the time since initialization in timer clock periods (F_CPU / TIMER_PRESCALER).
  */
-double f_timer_interval(uint32_t ticks1, uint32_t ticks2) {
-    // the duration of 1 tick = 256 / F, where F - the frequency of timer clock
-    // so, duration of N ticks = N * 256 / F
-
-    // unsigned integers, subtract only least from greatest
-    if (ticks1 > ticks2) {
-        uint32_t t = ticks1;
-        ticks1 = ticks2;
-        ticks2 = t;
-    }
+uint32_t f_timer_get_counts() {
+    uint32_t ticks;
+    uint8_t counter;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ticks = g_timer_counter;
+        counter = TCNT0;
 
-    // the interval in ticks
-    double interval = ticks2 - ticks1;
+        // the timer has been cleared, but the interrupt isn't handled yet
+        if (TIFR & 1 << OCF0) {
+            ticks++;
+            counter = TCNT0;
+        }
+    }
 
-    return interval * 256.0 / TIMER_CLOCK_FREQ;
+    return ticks * TIMER_COUNTS_PER_TICK + counter;
 }
 
 
 /*
- * Returns the amount of timer ticks for time interval
+ * One tick of timer has passed.
  */
-uint32_t f_timer_ticks(double time_interval) {
-    // the duration of 1 tick = 256 / F, where F - the frequency of timer clock
-    // so, the amount of ticks in time interval = t * F / 256
-    return (uint32_t)(time_interval * TIMER_CLOCK_FREQ / 256.0);
-}
\ No newline at end of file
+ISR(TIMER0_COMP_vect) {
+    g_timer_counter++;
+
+    // the heaters are switched on ticks
+    f_pwm_tick();
+}
@@ -3,7 +3,19 @@
 
 #include <stdint.h>
 
-#define TIMER_CLOCK_FREQ ((double)F_CPU / 128.0)
+// the frequency of timer ticks (in Hz)
+#define TIMER_TICK_FREQ 1000UL
+
+// the prescaler of 8-bit timer clock
+#define TIMER_PRESCALER 64UL
+
+// the amount of timer clock periods in one tick
+#define TIMER_COUNTS_PER_TICK (F_CPU / TIMER_PRESCALER / TIMER_TICK_FREQ)
+
+// the amount of timer ticks for time interval (in seconds)
+// use it with constants only, then it is calculated at compile time
+#define TIMER_TICKS(time_interval) \
+	((uint32_t)((time_interval) * TIMER_TICK_FREQ + 0.5))
 
 /*
  * Initialize the timers
@@ -11,21 +23,16 @@
 void f_init_timers();
 
 /*
- * Check if one clock cycle of 8-bit timer has passed.
- * Returns 1 if timer has ticked.
- * Resets the interrupt flag of 8-bit timer.
- */
-int f_check_timer_tick();
-
-/*
- * Returns the time interval between two timer ticks (in seconds)
+ * Returns the amount of timer ticks since initialization.
+ * The counter overflows, so compare only the differences of ticks.
  */
-double f_timer_interval(uint32_t ticks1, uint32_t ticks2);
+uint32_t f_timer_get_ticks();
 
 /*
- * Returns the amount of timer ticks for time interval
+ * Returns the time since initialization in timer clock periods (F_CPU / TIMER_PRESCALER).
+ * The counter overflows, so compare only the differences.
  */
-uint32_t f_timer_ticks(double time_interval);
+uint32_t f_timer_get_counts();
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,202 @@
+/*
+    Benchmark of thermistor sample filtering (host only).
+
+    It feeds the filter stages of filter.h with simulated conversions of
+    a thermistor (the B equation, gaussian noise and rare spikes) and prints
+    a CSV line per path and noise level:
+        path,<noise in LSB>,<conversions per sample>,<RMS error>,<max error>,
+        <samples to 90% of step>,<host ns per sample>
+    The errors are in centidegrees, the step is 1 degree Celsius without noise.
+    The paths:
+        raw - one conversion, f_thermistor_centidegrees() (the old path)
+        oversample - FILTER_OVERSAMPLE conversions, decimated
+        median - and the median of 3
+        iir - and the IIR low-pass
+        pipeline - f_filter_update() as configured in configuration.h
+    The AVR cycles of f_filter_update() are measured by benchmark.sh.
+
+    Usage: ./bench_filter [noise in LSB ...], 0 0.5 1 2 4 by default
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../configuration.h"
+#include "../filter.h"
+#include "../thermistor.h"
+
+// the samples errors are taken over (after the filters have settled)
+#define BENCH_SAMPLES 20000
+#define BENCH_WARMUP 100
+// the temperatures the samples are taken at (in degrees Celsius)
+#define BENCH_T_MIN 28.0
+#define BENCH_T_MAX 42.0
+// the probability of spike and its amplitude (in LSB)
+#define BENCH_SPIKE_PROBABILITY 0.01
+#define BENCH_SPIKE 50.0
+
+// the stages of path
+#define STAGE_OVERSAMPLE 1
+#define STAGE_MEDIAN 2
+#define STAGE_IIR 4
+#define STAGE_PIPELINE 8
+
+typedef struct {
+    const char *name;
+    uint8_t stages;
+} path;
+
+static const path PATHS[] = {
+    { "raw", 0 },
+    { "oversample", STAGE_OVERSAMPLE },
+    { "median", STAGE_OVERSAMPLE | STAGE_MEDIAN },
+    { "iir", STAGE_OVERSAMPLE | STAGE_MEDIAN | STAGE_IIR },
+    { "pipeline", STAGE_PIPELINE },
+};
+#define PATH_AMOUNT (sizeof(PATHS) / sizeof(PATHS[0]))
+
+
+// the uniform random value from 0 to 1 (not including 0)
+static double f_bench_random(void) {
+    return (rand() + 1.0) / (RAND_MAX + 1.0);
+}
+
+// one conversion of the thermistor at temperature t, see f_sim_read_ADC()
+static uint16_t f_bench_convert(double t, double noise) {
+    double r = MOHG_THERMISTOR_R
+        * exp(MOHG_THERMISTOR_B * (1.0 / (t + 273.15) - 1.0 / (MOHG_THERMISTOR_T + 273.15)));
+    double adc = 1023.0 * MOHG_THERMISTOR_DIVIDER_R / (r + MOHG_THERMISTOR_DIVIDER_R);
+
+    if (noise) {
+        // Box-Muller
+        adc += noise * sqrt(-2.0 * log(f_bench_random())) * cos(2.0 * M_PI * f_bench_random());
+
+        if (f_bench_random() < BENCH_SPIKE_PROBABILITY)
+            adc += f_bench_random() < 0.5 ? -BENCH_SPIKE : BENCH_SPIKE;
+    }
+
+    if (adc < 0) adc = 0;
+    if (adc > 1023) adc = 1023;
+
+    return (uint16_t)(adc + 0.5);
+}
+
+// the sum of conversions, like the ADC sweep
+static uint16_t f_bench_sum(const path *p, const uint16_t *conversions) {
+    uint8_t amount = p->stages ? FILTER_OVERSAMPLE : 1;
+
+    uint16_t sum = 0;
+    for (uint8_t i = 0; i < amount; i++) sum += conversions[i];
+
+    return sum;
+}
+
+// one sample through the path, returns the temperature in centidegrees
+static int16_t f_bench_sample(const path *p, filter_state *filter, uint16_t sum) {
+    if (!p->stages) return f_thermistor_centidegrees(sum);
+
+    if (p->stages & STAGE_PIPELINE)
+        return f_thermistor_centidegrees_fine(f_filter_update(filter, sum));
+
+    uint16_t value = f_filter_decimate(sum);
+    if (!filter->is_started) f_filter_start(filter, value);
+
+    if (p->stages & STAGE_MEDIAN) value = f_filter_median(filter, value);
+    if (p->stages & STAGE_IIR) value = f_filter_iir(filter, value);
+
+    return f_thermistor_centidegrees_fine(value);
+}
+
+// the samples the noiseless path takes to reach 90% of 1 degree step
+static uint16_t f_bench_step(const path *p) {
+    double t = (BENCH_T_MIN + BENCH_T_MAX) / 2;
+    uint16_t conversions[FILTER_OVERSAMPLE];
+    filter_state filter = { 0 };
+
+    for (uint8_t i = 0; i < FILTER_OVERSAMPLE; i++) conversions[i] = f_bench_convert(t, 0);
+    for (uint16_t n = 0; n < BENCH_WARMUP; n++) f_bench_sample(p, &filter, f_bench_sum(p, conversions));
+
+    for (uint8_t i = 0; i < FILTER_OVERSAMPLE; i++) conversions[i] = f_bench_convert(t + 1.0, 0);
+    int16_t final = 100 * (t + 1.0);
+
+    for (uint16_t n = 1; n < BENCH_WARMUP; n++) {
+        int16_t value = f_bench_sample(p, &filter, f_bench_sum(p, conversions));
+
+        if (value >= final - 10) return n;
+    }
+
+    return BENCH_WARMUP;
+}
+
+static uint64_t f_bench_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static void f_bench_path(const path *p, double noise) {
+    // the conversions are made beforehand, so only the filter is timed
+    static uint16_t sums[BENCH_SAMPLES];
+    static int16_t values[BENCH_SAMPLES];
+    static double temperatures[BENCH_SAMPLES];
+
+    uint16_t conversions[FILTER_OVERSAMPLE];
+    srand(1);
+
+    for (uint32_t n = 0; n < BENCH_SAMPLES; n++) {
+        // the temperature changes slowly, like the one of finger
+        double phase = (double)n / BENCH_SAMPLES;
+        temperatures[n] = BENCH_T_MIN + (BENCH_T_MAX - BENCH_T_MIN) * (0.5 - 0.5 * cos(2.0 * M_PI * phase));
+
+        for (uint8_t i = 0; i < FILTER_OVERSAMPLE; i++)
+            conversions[i] = f_bench_convert(temperatures[n], noise);
+
+        sums[n] = f_bench_sum(p, conversions);
+    }
+
+    filter_state filter = { 0 };
+
+    uint64_t start = f_bench_ns();
+    for (uint32_t n = 0; n < BENCH_SAMPLES; n++)
+        values[n] = f_bench_sample(p, &filter, sums[n]);
+    uint64_t ns = f_bench_ns() - start;
+
+    double squares = 0;
+    double max_error = 0;
+
+    for (uint32_t n = BENCH_WARMUP; n < BENCH_SAMPLES; n++) {
+        double error = fabs(values[n] - 100.0 * temperatures[n]);
+
+        squares += error * error;
+        if (error > max_error) max_error = error;
+    }
+
+    printf("%s,%.1f,%u,%.1f,%.0f,%u,%.1f\n",
+        p->name,
+        noise,
+        p->stages ? FILTER_OVERSAMPLE : 1,
+        sqrt(squares / (BENCH_SAMPLES - BENCH_WARMUP)),
+        max_error,
+        f_bench_step(p),
+        (double)ns / BENCH_SAMPLES);
+}
+
+int main(int argc, char **argv) {
+    static const double DEFAULT_NOISES[] = { 0.0, 0.5, 1.0, 2.0, 4.0 };
+
+    printf("path,noise_lsb,conversions,rms_error_cd,max_error_cd,step_samples,host_ns_per_sample\n");
+
+    uint8_t noise_amount = argc > 1 ? (size_t)argc - 1 : sizeof(DEFAULT_NOISES) / sizeof(DEFAULT_NOISES[0]);
+
+    for (uint8_t i = 0; i < noise_amount; i++) {
+        double noise = argc > 1 ? atof(argv[i + 1]) : DEFAULT_NOISES[i];
+
+        for (uint8_t j = 0; j < PATH_AMOUNT; j++)
+            f_bench_path(&PATHS[j], noise);
+    }
+
+    return 0;
+}
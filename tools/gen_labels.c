@@ -0,0 +1,119 @@
+/*
+    Build-time generator of pre-rasterized labels.
+    It runs on the host and prints 'labels.h' to stdout.
+
+    The constant strings of UI are drawn with the default symbol resolver,
+    exactly like SSD1306_graphics_text() does, and stored as PROGMEM bitmaps.
+    Must be compiled with -fexec-charset=CP866, like the firmware.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../configuration.h"
+#include "../SSD1306/Bitmaps.h"
+
+// the whole config page is constant, it is formatted at startup
+static char config_text[64];
+
+// the labels: name of bitmap and text
+static const char *LABELS[][2] = {
+    { "LABEL_DECREASE", STR_DECREASE_TEMP_TITLE },
+    { "LABEL_INCREASE", STR_INCREASE_TEMP_TITLE },
+    { "LABEL_START", STR_START_TITLE },
+    { "LABEL_STOP", STR_STOP_TITLE },
+    { "LABEL_TARGET", "ЦЕЛЬ: " },
+    { "LABEL_NOW", "СЕЙЧАС: " },
+    { "LABEL_MONITOR", "МОНИТОР ДАТЧИКОВ" },
+    { "LABEL_CONFIG", config_text },
+};
+
+// the largest label
+#define CANVAS_W 128
+#define CANVAS_H 64
+
+static uint8_t canvas[CANVAS_H / 8][CANVAS_W];
+
+/*
+ * Draw the text on canvas, returns its dimensions.
+ * The layout is the same as in SSD1306_graphics_text() and the measurement
+ * is the same as in BMP_calculate_string_dimensions().
+ */
+void f_rasterize(const char *str, uint16_t *text_w, uint16_t *text_h) {
+    memset(canvas, 0, sizeof(canvas));
+
+    uint16_t x = 0;
+    uint16_t y = 0;
+
+    *text_w = 0;
+    *text_h = 0;
+
+    for (int i = 0; str[i]; ++i) {
+        if (str[i] == '\n') {
+            y += 9;
+            x = 0;
+            continue;
+        }
+
+        uint16_t w, h;
+        uint8_t *bmp = BMP_default_symbol_resolver(str[i], &w, &h);
+
+        for (uint16_t bx = 0; bx < w; bx++) {
+            for (uint16_t by = 0; by < h; by++) {
+                if (!(bmp[by / 8 * w + bx] & 1 << by % 8)) continue;
+
+                uint16_t fx = x + bx;
+                uint16_t fy = y + by;
+                if (fx >= CANVAS_W || fy >= CANVAS_H) continue;
+
+                canvas[fy / 8][fx] |= 1 << fy % 8;
+            }
+        }
+
+        x += w + 1;
+
+        if (x > *text_w) *text_w = x;
+        if (y + h > *text_h) *text_h = y + h;
+    }
+}
+
+int main(void) {
+    // the temperatures may be expressions, so they are evaluated here
+    snprintf(config_text, sizeof(config_text),
+        "МАКС: %dd\nМИН: %dd\nРАЗБРОС: %dd",
+        (int)(TEMPERATURE_MAX),
+        (int)(TEMPERATURE_MIN),
+        (int)(TEMPERATURE_GAP));
+
+    printf("// Generated by tools/gen_labels.c from configuration.h and Bitmaps.h, do not edit.\n");
+    printf("\n");
+    printf("#ifndef MOHG__LABELS_H\n");
+    printf("#define MOHG__LABELS_H\n");
+    printf("\n");
+    printf("#include <stdint.h>\n");
+    printf("#include <avr/pgmspace.h>\n");
+
+    for (unsigned l = 0; l < sizeof(LABELS) / sizeof(LABELS[0]); l++) {
+        const char *name = LABELS[l][0];
+
+        uint16_t w, h;
+        f_rasterize(LABELS[l][1], &w, &h);
+
+        printf("\n");
+        printf("#define %s_W %u\n", name, w);
+        printf("#define %s_H %u\n", name, h);
+        printf("static const uint8_t %s[] PROGMEM = {", name);
+
+        for (uint16_t line = 0; line * 8 < h; line++)
+            for (uint16_t x = 0; x < w; x++)
+                printf("%s0x%02x,", x % 12 ? " " : "\n\t", canvas[line][x]);
+
+        printf("\n};\n");
+    }
+
+    printf("\n");
+    printf("#endif\n");
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/*
+    Build-time generator of the ADC-to-temperature table.
+    It runs on the host and prints 'thermistor_table.h' to stdout.
+
+    The values are produced by the reference float functions from utils.c,
+    so the table always follows the thermistor parameters in configuration.h.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "../configuration.h"
+#include "../utils.h"
+
+// the table has an entry every 2^STEP_BITS ADC values
+#define STEP_BITS 3
+#define ENTRIES ((1024 >> STEP_BITS) + 1)
+
+// the range used to report the accuracy (in degrees Celcius)
+#define ACCURACY_MIN 0.0
+#define ACCURACY_MAX 60.0
+
+/*
+ * Reference temperature for the ADC value (in degrees Celcius).
+ * The ends of ADC range mean zero and infinite resistance, they are clamped.
+ */
+double f_reference_temperature(int adc_val) {
+    if (adc_val < 1) adc_val = 1;
+    if (adc_val > 1022) adc_val = 1022;
+
+    double r = f_calculate_resistance(adc_val, MOHG_THERMISTOR_DIVIDER_R);
+
+    return f_calculate_temperature(
+        MOHG_THERMISTOR_B,
+        MOHG_THERMISTOR_R,
+        r,
+        MOHG_THERMISTOR_T);
+}
+
+/*
+ * Temperature in centidegrees, clamped to int16_t.
+ */
+int16_t f_to_centidegrees(double temperature) {
+    double centidegrees = round(temperature * 100.0);
+
+    if (centidegrees < INT16_MIN) return INT16_MIN;
+    if (centidegrees > INT16_MAX) return INT16_MAX;
+
+    return (int16_t)centidegrees;
+}
+
+int main(void) {
+    int16_t table[ENTRIES];
+
+    for (int i = 0; i < ENTRIES; i++)
+        table[i] = f_to_centidegrees(f_reference_temperature(i << STEP_BITS));
+
+    // the same interpolation as f_thermistor_centidegrees() does
+    double max_error = 0;
+    for (int adc_val = 0; adc_val < 1024; adc_val++) {
+        double reference = f_reference_temperature(adc_val);
+        if (reference < ACCURACY_MIN || reference > ACCURACY_MAX) continue;
+
+        int16_t t1 = table[adc_val >> STEP_BITS];
+        int16_t t2 = table[(adc_val >> STEP_BITS) + 1];
+        int16_t fraction = adc_val & ((1 << STEP_BITS) - 1);
+        int16_t result = t1 + (int16_t)(((uint32_t)(t2 - t1) * fraction) >> STEP_BITS);
+
+        double error = fabs(result / 100.0 - reference);
+        if (error > max_error) max_error = error;
+    }
+
+    printf("// Generated by tools/gen_thermistor_table.c from configuration.h, do not edit.\n");
+    printf("// Max interpolation error from %.0f to %.0f degrees: %.3f degrees.\n",
+        ACCURACY_MIN, ACCURACY_MAX, max_error);
+    printf("\n");
+    printf("#ifndef MOHG__THERMISTOR_TABLE_H\n");
+    printf("#define MOHG__THERMISTOR_TABLE_H\n");
+    printf("\n");
+    printf("#include <stdint.h>\n");
+    printf("#include <avr/pgmspace.h>\n");
+    printf("\n");
+    printf("// the table has an entry every 2^THERMISTOR_TABLE_STEP_BITS ADC values\n");
+    printf("#define THERMISTOR_TABLE_STEP_BITS %d\n", STEP_BITS);
+    printf("\n");
+    printf("// temperature in centidegrees for ADC values 0, %d, %d, ... 1024\n",
+        1 << STEP_BITS, 2 << STEP_BITS);
+    printf("static const int16_t THERMISTOR_TABLE[%d] PROGMEM = {", ENTRIES);
+    for (int i = 0; i < ENTRIES; i++)
+        printf("%s%6d,", i % 8 ? " " : "\n\t", table[i]);
+    printf("\n};\n");
+    printf("\n");
+    printf("#endif\n");
+
+    return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef MOHG__HOST_AVR_PGMSPACE_H
+#define MOHG__HOST_AVR_PGMSPACE_H
+
+// Host stand-in for <avr/pgmspace.h>, used by the build-time generators.
+// There is only one address space on host, so flash is ordinary memory.
+
+#include <stdint.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+
+#endif
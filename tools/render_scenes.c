@@ -0,0 +1,229 @@
+/*
+    Renderer of every UI screen with scripted state (host only).
+
+    It links the firmware with the host backend of HAL (see compile_host.sh),
+    draws every scene of scenes.h, writes the images as PBM and prints a CSV line per scene:
+        scene,<name>,<kernel bytes>,<I2C bytes>,<bus time in us>,<host ns per frame>
+    The frame is a full redraw: the UI state and the display are invalidated before each scene.
+    The kernel bytes are the bytes of framebuffer or strip the drawing kernels visit
+    (SSD1306_KERNEL_COUNTERS), with the I2C bytes they are the cost of scene that
+    doesn't depend on the host. The host time is noisy, it is only printed.
+    The AVR cycles of scenes are measured by benchmark_scenes.sh.
+
+    Usage: ./render_scenes <output directory> [reference directory]
+    The images and the costs (SCENES_COSTS) are written to the output directory and
+    compared with the reference ones (SCENES_REFERENCE by default). The exit code is 1
+    if any image differs or is missing, or a cost exceeds the reference one by more
+    than SCENES_TOLERANCE percent.
+    To update the references after an intended change of UI or cost, render into SCENES_REFERENCE.
+    Built with -DSSD1306_PAGE_STREAMING, it also reports the use of display list,
+    the exit code is 1 if it has overflowed.
+*/
+
+#define main f_firmware_main
+#include "../main.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "scenes.h"
+
+// the amount of frames the host time is averaged over
+#define SCENE_REPEATS 1000
+
+// the checked-in images and costs of scenes, relative to the root of repository
+#define SCENES_REFERENCE "tools/scenes"
+
+// the file of costs, the render modes have their own
+#ifdef SSD1306_PAGE_STREAMING
+#define SCENES_COSTS "costs_streaming.csv"
+#else
+#define SCENES_COSTS "costs.csv"
+#endif
+
+// the allowed growth of cost (in percent)
+#define SCENES_TOLERANCE 10
+
+// the cost of scene that doesn't depend on the host
+typedef struct {
+    uint32_t kernel_bytes;
+    uint32_t i2c_bytes;
+} scene_cost;
+
+
+// returns 1 if the files are equal
+static uint8_t f_files_equal(const char *a, const char *b) {
+    FILE *fa = fopen(a, "rb");
+    FILE *fb = fopen(b, "rb");
+    uint8_t is_equal = fa && fb;
+
+    while (is_equal) {
+        int ca = fgetc(fa);
+        int cb = fgetc(fb);
+
+        if (ca != cb) is_equal = 0;
+        if (ca == EOF) break;
+    }
+
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+
+    return is_equal;
+}
+
+// reads the costs of scenes from the file, returns 1 if all of them are there
+static uint8_t f_read_costs(const char *path, scene_cost *costs) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+
+    uint8_t is_found[SCENE_AMOUNT] = { 0 };
+    char name[64];
+    scene_cost cost;
+
+    // the header
+    fscanf(f, "%*[^\n]\n");
+
+    while (fscanf(f, "%63[^,],%u,%u\n", name, &cost.kernel_bytes, &cost.i2c_bytes) == 3) {
+        for (uint8_t i = 0; i < SCENE_AMOUNT; i++) {
+            if (strcmp(name, SCENES[i].name)) continue;
+
+            costs[i] = cost;
+            is_found[i] = 1;
+        }
+    }
+
+    fclose(f);
+
+    for (uint8_t i = 0; i < SCENE_AMOUNT; i++)
+        if (!is_found[i]) return 0;
+
+    return 1;
+}
+
+// returns 1 if the cost has grown by more than SCENES_TOLERANCE percent
+static uint8_t f_is_over(uint32_t value, uint32_t reference) {
+    return (uint64_t)value * 100 > (uint64_t)reference * (100 + SCENES_TOLERANCE);
+}
+
+static uint64_t f_now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <output directory> [reference directory]\n", argv[0]);
+        return 2;
+    }
+
+    const char *output = argv[1];
+    const char *reference = argc > 2 ? argv[2] : SCENES_REFERENCE;
+
+    uint8_t differs = 0;
+    scene_cost costs[SCENE_AMOUNT];
+
+    // the drivers and the display, like on the device
+    f_init();
+
+    printf("scene,name,kernel_bytes,i2c_bytes,bus_time_us,host_ns_per_frame\n");
+
+    for (uint8_t i = 0; i < SCENE_AMOUNT; i++) {
+        const scene *s = &SCENES[i];
+        f_scene_apply(s);
+
+        // the cost of one full redraw
+        display_stats before = *f_display_get_stats();
+        uint32_t bus_before = f_display_bus_time_us();
+        SSD1306_kernel_bytes = 0;
+
+        f_scene_draw();
+
+        costs[i].kernel_bytes = SSD1306_kernel_bytes;
+        costs[i].i2c_bytes = f_display_get_stats()->bytes - before.bytes;
+        uint32_t bus_time = f_display_bus_time_us() - bus_before;
+
+        char path[256];
+        snprintf(path, sizeof(path), "%s/%s.pbm", output, s->name);
+
+        if (!f_display_write_pbm(path)) {
+            fprintf(stderr, "can't write '%s'\n", path);
+            return 2;
+        }
+
+        // the time of full redraws on host
+        uint64_t begin = f_now_ns();
+        for (uint16_t r = 0; r < SCENE_REPEATS; r++)
+            f_scene_draw();
+        uint64_t frame_ns = (f_now_ns() - begin) / SCENE_REPEATS;
+
+        printf("scene,%s,%u,%u,%u,%llu\n",
+            s->name,
+            costs[i].kernel_bytes,
+            costs[i].i2c_bytes,
+            bus_time,
+            (unsigned long long)frame_ns);
+
+        char reference_path[256];
+        snprintf(reference_path, sizeof(reference_path), "%s/%s.pbm", reference, s->name);
+
+        if (!f_files_equal(path, reference_path)) {
+            fprintf(stderr, "%s differs from %s\n", path, reference_path);
+            differs = 1;
+        }
+    }
+
+    // the costs, they are compared after writing, so the references can be updated
+    char path[256];
+    snprintf(path, sizeof(path), "%s/" SCENES_COSTS, output);
+
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "can't write '%s'\n", path);
+        return 2;
+    }
+
+    fprintf(f, "name,kernel_bytes,i2c_bytes\n");
+    for (uint8_t i = 0; i < SCENE_AMOUNT; i++)
+        fprintf(f, "%s,%u,%u\n", SCENES[i].name, costs[i].kernel_bytes, costs[i].i2c_bytes);
+    fclose(f);
+
+    scene_cost references[SCENE_AMOUNT];
+    snprintf(path, sizeof(path), "%s/" SCENES_COSTS, reference);
+
+    if (!f_read_costs(path, references)) {
+        fprintf(stderr, "%s is missing or incomplete\n", path);
+        differs = 1;
+    } else {
+        for (uint8_t i = 0; i < SCENE_AMOUNT; i++) {
+            if (f_is_over(costs[i].kernel_bytes, references[i].kernel_bytes)
+                    || f_is_over(costs[i].i2c_bytes, references[i].i2c_bytes)) {
+                fprintf(stderr, "%s costs %u kernel bytes and %u I2C bytes, more than %u%% over %u and %u\n",
+                    SCENES[i].name,
+                    costs[i].kernel_bytes,
+                    costs[i].i2c_bytes,
+                    SCENES_TOLERANCE,
+                    references[i].kernel_bytes,
+                    references[i].i2c_bytes);
+                differs = 1;
+            }
+        }
+    }
+
+#ifdef SSD1306_PAGE_STREAMING
+    // the display list must hold every scene
+    fprintf(stderr, "display list: %u of %u bytes used, %u operations dropped\n",
+        SSD1306_display_list_peak,
+        (unsigned)SSD1306_DISPLAY_LIST_SIZE,
+        SSD1306_display_list_overflows);
+
+    if (SSD1306_display_list_overflows) differs = 1;
+#endif
+
+    return differs;
+}
@@ -0,0 +1,59 @@
+/*
+    Cycle counter of every UI screen with scripted state (AVR, see benchmark_scenes.sh).
+
+    It links the firmware built with MOHG_PROFILE, draws every scene of scenes.h
+    (a full redraw, like render_scenes.c) and prints over USART a line per scene:
+        scene,<name>,<cycles>
+    and the line "scenes_end" after the last one.
+    The cycles are the fewest of SCENE_CYCLE_REPEATS redraws, so the interrupts
+    of timers disturb them less. The previous frame is sent before each redraw,
+    so in the framebuffer mode the bus isn't counted, the page-streaming render
+    waits for its strips and counts it.
+*/
+
+#define main f_firmware_main
+#include "../main.c"
+#undef main
+
+#include "scenes.h"
+
+// the amount of redraws the fewest cycles are taken from
+#define SCENE_CYCLE_REPEATS 4
+
+
+int main(void) {
+    // the drivers and the display, like on the device
+    f_init();
+
+    char line[64];
+    format_buffer text;
+
+    for (uint8_t i = 0; i < SCENE_AMOUNT; i++) {
+        const scene *s = &SCENES[i];
+        f_scene_apply(s);
+
+        uint32_t fewest = UINT32_MAX;
+
+        for (uint8_t r = 0; r < SCENE_CYCLE_REPEATS; r++) {
+            SSD1306_wait();
+
+            uint32_t begin = f_profile_cycles();
+            f_scene_draw();
+            uint32_t cycles = f_profile_cycles() - begin;
+
+            if (cycles < fewest) fewest = cycles;
+        }
+
+        f_format_init(&text, line, sizeof(line));
+        f_format_str(&text, "scene,");
+        f_format_str(&text, s->name);
+        f_format_char(&text, ',');
+        f_format_int(&text, fewest);
+        f_format_char(&text, '\n');
+        f_profile_print(line);
+    }
+
+    f_profile_print("scenes_end\n");
+
+    while (1);
+}
@@ -0,0 +1,58 @@
+#ifndef MOHG__TOOLS_SCENES_H
+#define MOHG__TOOLS_SCENES_H
+
+/*
+    The scripted UI states of every f_update_display() screen, shared by
+    render_scenes.c (host) and scene_cycles.c (AVR under simavr).
+    Include it after main.c, it sets the globals of firmware.
+*/
+
+// the state the screen depends on
+typedef struct {
+    const char *name;
+    uint8_t menu;
+    uint8_t debug_page;
+    uint8_t is_heating_active;
+    int16_t target;
+    // the temperatures of fingers (in centidegrees)
+    int16_t temperatures[THERMISTOR_AMOUNT];
+    // the duties of heaters (in PWM steps)
+    uint8_t duties[HEATER_AMOUNT];
+} scene;
+
+static const scene SCENES[] = {
+    { "main_idle", MENU_MAIN, 0, 0, TEMPERATURE_INITIAL, { 3012, 3105, 2990, 3300, 3151 }, { 0 } },
+    { "main_heating", MENU_MAIN, 0, 1, TEMPERATURE_INITIAL, { 3612, 3705, 3590, 3650, 3751 }, { 60, 0, 70, 30, 100 } },
+    { "main_target_min", MENU_MAIN, 0, 1, TEMPERATURE_MIN, { 2800, 2800, 2800, 2800, 2800 }, { 0 } },
+    { "main_target_max", MENU_MAIN, 0, 1, TEMPERATURE_MAX, { 4100, 4100, 4100, 4100, 4100 }, { 100, 100, 100, 100, 100 } },
+    { "main_cold", MENU_MAIN, 0, 0, TEMPERATURE_INITIAL, { -512, -490, -530, -505, -520 }, { 0 } },
+    { "monitor_off", MENU_DEBUG, DEBUG_MEUN_MONITOR, 0, TEMPERATURE_INITIAL, { 3012, 3105, 2990, 3300, 3151 }, { 0 } },
+    { "monitor_heating", MENU_DEBUG, DEBUG_MEUN_MONITOR, 1, TEMPERATURE_INITIAL, { 3612, 3705, 3590, 3650, 3751 }, { 100, 50, 0, 25, 75 } },
+    { "config", MENU_DEBUG, DEBUG_MEUN_CONFIG, 0, TEMPERATURE_INITIAL, { 0 }, { 0 } },
+};
+#define SCENE_AMOUNT (sizeof(SCENES) / sizeof(SCENES[0]))
+
+
+// sets the state of firmware
+static void f_scene_apply(const scene *s) {
+    g_active_menu = s->menu;
+    g_debug_menu_page = s->debug_page;
+    g_is_heating_active = s->is_heating_active;
+    g_target_temperature = s->target;
+
+    for (uint8_t i = 0; i < THERMISTOR_AMOUNT; i++)
+        g_finger_temperatures[i] = s->temperatures[i];
+
+    // the monitor shows the duties
+    for (uint8_t i = 0; i < HEATER_AMOUNT; i++)
+        f_pwm_set_duty(i, s->duties[i]);
+}
+
+// draws the scene as a full redraw: the UI state and the display are invalidated
+static void f_scene_draw(void) {
+    f_invalidate_display();
+    SSD1306_invalidate();
+    f_update_display();
+}
+
+#endif
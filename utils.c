@@ -1,5 +1,7 @@
 #include "utils.h"
 
+#include <math.h>
+
 
 double f_calculate_temperature(double B, double R1, double R2, double T1) {
 	// we need Kelvins